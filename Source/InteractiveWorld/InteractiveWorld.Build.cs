@@ -26,6 +26,7 @@ public class InteractiveWorld : ModuleRules
 			new string[]
 			{
 				"Core",
+				"Niagara",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -38,11 +39,19 @@ public class InteractiveWorld : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"RenderCore",
+				"RHI",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
 		
 		
+		if (Target.bBuildEditor)
+		{
+			//Baking layers creates texture assets
+			PrivateDependencyModuleNames.Add("AssetRegistry");
+		}
+		
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{
@@ -0,0 +1,97 @@
+// Copyright 2023 Sun BoHeng
+
+#include "CaptureScheduler.h"
+
+//Intersect in XY only,captures cover full height of their requests
+static bool IntersectXY(const FBox& A, const FBox& B)
+{
+	return A.Min.X <= B.Max.X && A.Max.X >= B.Min.X && A.Min.Y <= B.Max.Y && A.Max.Y >= B.Min.Y;
+}
+
+int32 FIWCaptureScheduler::GetUpdateInterval(float ViewDistance) const
+{
+	if (IntervalDistance <= 0)
+	{
+		return 0;
+	}
+	return FMath::Clamp(FMath::FloorToInt(ViewDistance / IntervalDistance), 0, FMath::Max(MaxInterval, 0));
+}
+
+void FIWCaptureScheduler::Schedule(const TArray<FIWCaptureRequest>& Requests, TArray<FIWCaptureJob>& OutJobs)
+{
+	OutJobs.Reset();
+	ReadyRequests.Reset();
+
+	//Find requests that moved and have waited long enough
+	for (int32 i = 0; i < Requests.Num(); i++)
+	{
+		const FIWCaptureRequest& Request = Requests[i];
+		FRequestState& State = States.FindOrAdd(Request.Id);
+		State.FramesSinceCapture++;
+		const bool bNeverCaptured = !State.LastCapturedBounds.IsValid;
+		const bool bMoved = bNeverCaptured
+			|| !State.LastCapturedBounds.Min.Equals(Request.Bounds.Min, MovementTolerance)
+			|| !State.LastCapturedBounds.Max.Equals(Request.Bounds.Max, MovementTolerance);
+		const int32 Interval = GetUpdateInterval(Request.ViewDistance);
+		if (!bMoved || State.FramesSinceCapture <= Interval)
+		{
+			continue;
+		}
+		//Never captured brushes go first,they have nothing to draw yet
+		const int32 Overdue = bNeverCaptured ? MAX_int32 : State.FramesSinceCapture - Interval;
+		ReadyRequests.Add({i, Overdue, Request.ViewDistance});
+	}
+	if (ReadyRequests.Num() == 0 || MaxCapturesPerFrame <= 0)
+	{
+		return;
+	}
+	ReadyRequests.Sort([](const FReadyRequest& A, const FReadyRequest& B)
+	{
+		return A.Overdue != B.Overdue ? A.Overdue > B.Overdue : A.ViewDistance < B.ViewDistance;
+	});
+
+	//Merge in priority order,so jobs are ordered by their most urgent request
+	for (const FReadyRequest& Ready : ReadyRequests)
+	{
+		const FBox& Bounds = Requests[Ready.Index].Bounds;
+		bool bMerged = false;
+		for (FIWCaptureJob& Job : OutJobs)
+		{
+			if (!IntersectXY(Job.Bounds.ExpandBy(MergeDistance), Bounds))
+			{
+				continue;
+			}
+			const FBox Merged = Job.Bounds + Bounds;
+			if (Merged.Max.X - Merged.Min.X > MaxCaptureSize || Merged.Max.Y - Merged.Min.Y > MaxCaptureSize)
+			{
+				continue;
+			}
+			Job.Bounds = Merged;
+			Job.RequestIndices.Add(Ready.Index);
+			bMerged = true;
+			break;
+		}
+		if (!bMerged && OutJobs.Num() < MaxCapturesPerFrame)
+		{
+			FIWCaptureJob& Job = OutJobs.AddDefaulted_GetRef();
+			Job.Bounds = Bounds;
+			Job.RequestIndices.Add(Ready.Index);
+		}
+	}
+
+	for (FIWCaptureJob& Job : OutJobs)
+	{
+		//Orthographic capture is square
+		const FVector Center = Job.Bounds.GetCenter();
+		const FVector Extent = Job.Bounds.GetExtent();
+		const double HalfSize = FMath::Max(Extent.X, Extent.Y);
+		Job.Bounds = FBox(FVector(Center.X - HalfSize, Center.Y - HalfSize, Job.Bounds.Min.Z),
+		                  FVector(Center.X + HalfSize, Center.Y + HalfSize, Job.Bounds.Max.Z));
+		for (const int32 Index : Job.RequestIndices)
+		{
+			FRequestState& State = States.FindChecked(Requests[Index].Id);
+			State.LastCapturedBounds = Requests[Index].Bounds;
+			State.FramesSinceCapture = 0;
+		}
+	}
+}
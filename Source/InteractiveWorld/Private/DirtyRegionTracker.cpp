@@ -0,0 +1,105 @@
+// Copyright 2023 Sun BoHeng
+
+#include "DirtyRegionTracker.h"
+
+//Overlapped part of two intersecting boxes
+static FBox2D ClampRect(const FBox2D& Rect, const FBox2D& Bounds)
+{
+	return FBox2D(FVector2D(FMath::Max(Rect.Min.X, Bounds.Min.X), FMath::Max(Rect.Min.Y, Bounds.Min.Y)),
+	              FVector2D(FMath::Min(Rect.Max.X, Bounds.Max.X), FMath::Min(Rect.Max.Y, Bounds.Max.Y)));
+}
+
+void FIWDirtyRegionTracker::AddRect(const FBox2D& Rect)
+{
+	if (!Rect.bIsValid)
+	{
+		return;
+	}
+	const FBox2D PaddedRect = Rect.ExpandBy(Padding);
+	//Overlapping a region,grow it.Otherwise add a new one
+	for (auto& Region : Regions)
+	{
+		if (Region.Rect.Intersect(PaddedRect))
+		{
+			Region.Rect += PaddedRect;
+			Region.Age = 0;
+			MergeToLimit();
+			return;
+		}
+	}
+	Regions.Add({PaddedRect, 0});
+	MergeToLimit();
+}
+
+void FIWDirtyRegionTracker::EndFrame()
+{
+	for (int32 i = Regions.Num() - 1; i >= 0; i--)
+	{
+		if (++Regions[i].Age > SettleFrames)
+		{
+			Regions.RemoveAtSwap(i, 1, false);
+		}
+	}
+}
+
+void FIWDirtyRegionTracker::Shift(const FVector2D& Offset)
+{
+	for (auto& Region : Regions)
+	{
+		Region.Rect = Region.Rect.ShiftBy(Offset);
+	}
+}
+
+void FIWDirtyRegionTracker::GetDirtyRects(const FBox2D& Bounds, TArray<FBox2D>& OutRects) const
+{
+	OutRects.Reset();
+	for (const auto& Region : Regions)
+	{
+		if (Region.Rect.Intersect(Bounds))
+		{
+			OutRects.Add(ClampRect(Region.Rect, Bounds));
+		}
+	}
+}
+
+FBox2D FIWDirtyRegionTracker::GetDirtyBounds(const FBox2D& Bounds) const
+{
+	FBox2D DirtyBounds(ForceInit);
+	for (const auto& Region : Regions)
+	{
+		if (Region.Rect.Intersect(Bounds))
+		{
+			DirtyBounds += ClampRect(Region.Rect, Bounds);
+		}
+	}
+	return DirtyBounds;
+}
+
+void FIWDirtyRegionTracker::MergeToLimit()
+{
+	const int32 Limit = FMath::Max(MaxRects, 1);
+	while (Regions.Num() > Limit)
+	{
+		//Find the pair that wastes least area after merging
+		int32 BestA = 0;
+		int32 BestB = 1;
+		double BestGrowth = TNumericLimits<double>::Max();
+		for (int32 a = 0; a < Regions.Num(); a++)
+		{
+			for (int32 b = a + 1; b < Regions.Num(); b++)
+			{
+				const FBox2D Merged = Regions[a].Rect + Regions[b].Rect;
+				const double Growth = Merged.GetArea() - Regions[a].Rect.GetArea() - Regions[b].Rect.GetArea();
+				if (Growth < BestGrowth)
+				{
+					BestGrowth = Growth;
+					BestA = a;
+					BestB = b;
+				}
+			}
+		}
+		Regions[BestA].Rect += Regions[BestB].Rect;
+		Regions[BestA].Age = FMath::Min(Regions[BestA].Age, Regions[BestB].Age);
+		Regions.RemoveAtSwap(BestB, 1, false);
+	}
+}
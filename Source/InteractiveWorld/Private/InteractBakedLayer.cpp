@@ -0,0 +1,42 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractBakedLayer.h"
+
+FIntPoint UInteractBakedLayer::GetTileCoordinate(const FVector2D& WorldLocation) const
+{
+	return FIntPoint(FMath::FloorToInt(WorldLocation.X / TileWorldSize), FMath::FloorToInt(WorldLocation.Y / TileWorldSize));
+}
+
+FBox2D UInteractBakedLayer::GetTileBounds(const FIntPoint& Coordinate) const
+{
+	const FVector2D Min = FVector2D(Coordinate) * TileWorldSize;
+	return FBox2D(Min, Min + FVector2D(TileWorldSize, TileWorldSize));
+}
+
+void UInteractBakedLayer::GetTilesInBounds(const FBox2D& WorldBounds, TArray<const FIWBakedTile*>& OutTiles) const
+{
+	OutTiles.Reset();
+	const FIntPoint Min = GetTileCoordinate(WorldBounds.Min);
+	const FIntPoint Max = GetTileCoordinate(WorldBounds.Max);
+	for (const auto& Tile : Tiles)
+	{
+		if (Tile.Coordinate.X >= Min.X && Tile.Coordinate.X <= Max.X && Tile.Coordinate.Y >= Min.Y && Tile.Coordinate.Y <= Max.Y)
+		{
+			OutTiles.Add(&Tile);
+		}
+	}
+}
+
+FIWBakedTile& UInteractBakedLayer::FindOrAddTile(const FIntPoint& Coordinate)
+{
+	for (auto& Tile : Tiles)
+	{
+		if (Tile.Coordinate == Coordinate)
+		{
+			return Tile;
+		}
+	}
+	FIWBakedTile& Tile = Tiles.AddDefaulted_GetRef();
+	Tile.Coordinate = Coordinate;
+	return Tile;
+}
@@ -2,8 +2,10 @@
 
 #include "InteractBrush.h"
 
+#include "InteractiveWorld.h"
 #include "InteractiveWorldBPLibrary.h"
 #include "InteractiveWorldSubsystem.h"
+#include "WorldDrawingBoard.h"
 #include "WorldInteractVolume.h"
 #include "Engine/World.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -19,7 +21,7 @@ UInteractBrush::UInteractBrush()
 {
 }
 
-bool UInteractBrush::PrepareForDrawing(TArray<TSubclassOf<AWorldDrawingBoard>>& NoVolumeDrawingBoardClass)
+bool UInteractBrush::PrepareForDrawing(const TArray<TSubclassOf<AWorldDrawingBoard>>& NoVolumeDrawingBoardClass)
 {
 	bSucceededDrawnThisTime = false;
 	PreviousT = CurrentT;
@@ -66,6 +68,70 @@ bool UInteractBrush::PrepareForDrawing(TArray<TSubclassOf<AWorldDrawingBoard>>&
 	return false;
 }
 
+void UInteractBrush::SetDrawEveryFrame(bool bNewDrawEveryFrame)
+{
+	bDrawEveryFrame = bNewDrawEveryFrame;
+	if (InteractiveWorldSubsystem)
+	{
+		InteractiveWorldSubsystem->UpdateEveryFrameBrush(this);
+	}
+}
+
+void UInteractBrush::DrawBrush()
+{
+	bDrawOnce = true;
+	if (InteractiveWorldSubsystem)
+	{
+		InteractiveWorldSubsystem->MarkBrushDirty(this);
+	}
+}
+
+bool UInteractBrush::TryMarkDirty()
+{
+	if (bMarkedDirty)
+	{
+		return false;
+	}
+	bMarkedDirty = true;
+	return true;
+}
+
+void UInteractBrush::OnBrushTransformUpdated(USceneComponent* UpdatedComponent,
+                                             EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (bMarkedDirty || bDrawEveryFrame || !bDrawOnMovement || !InteractiveWorldSubsystem)
+	{
+		return;
+	}
+	//Compare with transform when last prepared,small movements add up until they pass tolerance
+	if (!UKismetMathLibrary::NearlyEqual_TransformTransform(GetComponentTransform(), CurrentT,
+	                                                        MovementTolerance.X, MovementTolerance.Y, MovementTolerance.Z))
+	{
+		InteractiveWorldSubsystem->MarkBrushDirty(this);
+	}
+}
+
+bool UInteractBrush::PrepareForBake()
+{
+	//BeginPlay doesn't run in editor
+	bDrawOnRTInBlueprint = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UInteractBrush, DrawOnRT));
+	CurrentT = GetComponentTransform();
+	PreviousT = CurrentT;
+	//No MultiDraw when baking
+	bSucceededDrawnLastTime = false;
+	bSucceededDrawnThisTime = false;
+	bBuildWorldStampsInBlueprint = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UInteractBrush, BuildWorldStamps));
+	if (!UpdateDrawInfo())
+	{
+		return false;
+	}
+	if (bCacheWorldStamps)
+	{
+		BuildWorldStampCache();
+	}
+	return true;
+}
+
 bool UInteractBrush::ShouldDrawOn(AWorldDrawingBoard* DrawingBoard) const
 {
 	//If DrawingBoard uses InteractVolume,we should make sure we are in the same volume
@@ -76,23 +142,93 @@ bool UInteractBrush::ShouldDrawOn(AWorldDrawingBoard* DrawingBoard) const
 				|| DrawOnlyDrawingBoardsClassList.Find(DrawingBoard->GetClass()) != -1));
 }
 
-void UInteractBrush::PreDrawOnRT(AWorldDrawingBoard* DrawingBoard, UCanvas* CanvasDrawOn, FVector2D CanvasSize)
+int32 UInteractBrush::GetDrawTimes() const
 {
 	const float TraveledDistance = UKismetMathLibrary::Distance2D(
 		UInteractiveWorldBPLibrary::Vector3ToVector2(CurrentT.GetLocation()),
 		UInteractiveWorldBPLibrary::Vector3ToVector2(PreviousT.GetLocation()));
-	if (bUseMultiDraw && TraveledDistance > MaxDrawDistance && bSucceededDrawnLastTime)
+	//Scalability lowers density
+	const float DrawDistance = MaxDrawDistance / FMath::Max(InteractiveWorldSubsystem ? InteractiveWorldSubsystem->GetMultiDrawDensity() : 1.f, UE_KINDA_SMALL_NUMBER);
+	if (bUseMultiDraw && TraveledDistance > DrawDistance && bSucceededDrawnLastTime)
 	{
 		//Draw many times between two location
-		const int32 DrawTimes = FMath::CeilToInt(TraveledDistance / MaxDrawDistance);
-		for (int32 i = 1; i < DrawTimes; i++)
+		return FMath::CeilToInt(TraveledDistance / DrawDistance);
+	}
+	return 1;
+}
+
+void UInteractBrush::BuildWorldStamps_Implementation(float InterpolateRate, int32 DrawTimes)
+{
+}
+
+void UInteractBrush::BuildWorldStampCache()
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	//Only stamps added in "Build World Stamps" of this frame are cached,one call for each MultiDraw step
+	WorldStamps.Reset();
+	auto BuildStep = [this](float InterpolateRate, int32 DrawTimes)
+	{
+		if (bBuildWorldStampsInBlueprint)
+		{
+			BuildWorldStamps(InterpolateRate, DrawTimes);
+		}
+		else
 		{
-			DrawOnRT(DrawingBoard, CanvasDrawOn, CanvasSize,
-			         UKismetMathLibrary::Conv_IntToDouble(i) / UKismetMathLibrary::Conv_IntToDouble(DrawTimes), DrawTimes);
+			BuildWorldStamps_Implementation(InterpolateRate, DrawTimes);
 		}
+	};
+	const int32 DrawTimes = GetDrawTimes();
+	for (int32 i = 1; i < DrawTimes; i++)
+	{
+		BuildStep(static_cast<float>(i) / static_cast<float>(DrawTimes), DrawTimes);
+	}
+	BuildStep(1, 1);
+	WorldStampsFrame = GFrameCounter;
+}
+
+bool UInteractBrush::PreDrawOnRT(AWorldDrawingBoard* DrawingBoard, UCanvas* CanvasDrawOn, FVector2D CanvasSize)
+{
+	if (HasWorldStampCache())
+	{
+		//Stamps culled by this DrawingBoard don't count as drawn
+		if (DrawingBoard->AddWorldStampInstances(WorldStamps) == 0)
+		{
+			return false;
+		}
+		bSucceededDrawnThisTime = true;
+		return true;
+	}
+	if (bDrawOnRTInBlueprint)
+	{
+		//What Blueprint draws on canvas is unknown,assume it stays in cull radius
+		DrawingBoard->MarkBrushAreaDirty(UInteractiveWorldBPLibrary::Vector3ToVector2(PreviousT.GetLocation()),
+		                                 UInteractiveWorldBPLibrary::Vector3ToVector2(CurrentT.GetLocation()),
+		                                 GetCullRadius());
+	}
+	const int32 DrawTimes = GetDrawTimes();
+	for (int32 i = 1; i < DrawTimes; i++)
+	{
+		DrawOnRT(DrawingBoard, CanvasDrawOn, CanvasSize,
+		         UKismetMathLibrary::Conv_IntToDouble(i) / UKismetMathLibrary::Conv_IntToDouble(DrawTimes), DrawTimes);
 	}
 	DrawOnRT(DrawingBoard, CanvasDrawOn, CanvasSize, 1, 1);
     bSucceededDrawnThisTime = true;
+	return true;
+}
+
+bool UInteractBrush::PreDrawOnBoardNative(AWorldDrawingBoard* DrawingBoard) const
+{
+	if (HasWorldStampCache())
+	{
+		return DrawingBoard->AddWorldStampInstances(WorldStamps) > 0;
+	}
+	const int32 DrawTimes = GetDrawTimes();
+	for (int32 i = 1; i < DrawTimes; i++)
+	{
+		DrawOnBoardNative(DrawingBoard, static_cast<float>(i) / static_cast<float>(DrawTimes), DrawTimes);
+	}
+	DrawOnBoardNative(DrawingBoard, 1, 1);
+	return true;
 }
 
 void UInteractBrush::FinishDraw()
@@ -114,9 +250,47 @@ bool UInteractBrush::UpdateDrawInfo_Implementation()
 void UInteractBrush::DrawOnRT_Implementation(AWorldDrawingBoard* DrawingBoard, UCanvas* CanvasDrawOn,
                                              FVector2D CanvasSize, float InterpolateRate, int32 DrawTimes)
 {
+	DrawOnBoardNative(DrawingBoard, InterpolateRate, DrawTimes);
 }
 
 
+void UInteractBrush::RequestAsyncLineTrace(FVector Start, FVector End, TEnumAsByte<ECollisionChannel> TraceChannel)
+{
+	if (UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>())
+	{
+		Subsystem->RequestTrace(this, Start, End, TraceChannel);
+	}
+}
+
+void UInteractBrush::RequestAsyncOverlap(FVector Location, float Radius, TEnumAsByte<ECollisionChannel> TraceChannel)
+{
+	if (UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>())
+	{
+		Subsystem->RequestOverlap(this, Location, Radius, TraceChannel);
+	}
+}
+
+bool UInteractBrush::IsTraceResultCurrent(uint64 ResultFrame) const
+{
+	return InteractiveWorldSubsystem && ResultFrame == InteractiveWorldSubsystem->GetTraceDeliveryFrame();
+}
+
+FIWBrushTraceResult UInteractBrush::GetTraceResult() const
+{
+	return IsTraceResultCurrent(TraceResultFrame) ? TraceResult : FIWBrushTraceResult();
+}
+
+bool UInteractBrush::GetOverlapResult(bool& bOverlapping) const
+{
+	if (!IsTraceResultCurrent(OverlapResultFrame))
+	{
+		bOverlapping = false;
+		return false;
+	}
+	bOverlapping = bOverlapResult;
+	return bOverlapResultValid;
+}
+
 void UInteractBrush::EnterArea(AWorldInteractVolume* InteractVolume)
 {
 	OverlappingInteractVolumes.Add(InteractVolume);
@@ -133,52 +307,73 @@ void UInteractBrush::LeaveArea(AWorldInteractVolume* InteractVolume)
 void UInteractBrush::BeginPlay()
 {
 	Super::BeginPlay();
-	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->RegisterBrush(this);
+	if (bBakeToLayer)
+	{
+		//Already baked,costs nothing at runtime
+		return;
+	}
+	bDrawOnRTInBlueprint = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UInteractBrush, DrawOnRT));
+	bBuildWorldStampsInBlueprint = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UInteractBrush, BuildWorldStamps));
+	InteractiveWorldSubsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>();
+	//Registering,collision check and volume overlaps are done in batches,so spawning many brushes doesn't spike
+	InteractiveWorldSubsystem->QueueBrushActivation(this);
+}
+
+void UInteractBrush::ActivateBrush()
+{
+	//Brushes requested from other threads may not have begun play
+	InteractiveWorldSubsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>();
+	InteractiveWorldSubsystem->RegisterBrush(this);
+	//Bind once,even if brush is activated again after RequestRegisterBrush
+	TransformUpdated.RemoveAll(this);
+	TransformUpdated.AddUObject(this, &UInteractBrush::OnBrushTransformUpdated);
 	UpdateActiveState();
+}
 
-	//Check whether the Actor this Interact Brush attach to has collision with World Interact Volume
-	auto BrushCollisionWarning = [&]()->void
-	{
-		FMessageLog("PIE").Warning()
-		->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("Interact Brush: ")))))
-		->AddToken(FUObjectToken::Create(this))
-		->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("ISN'T attached to an Actor with Collisitn. Interact Volume will not work with it.")))))
-		->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("Please make Actor: ")))))
-		->AddToken(FUObjectToken::Create(this->GetOwner()))
-		->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("has query collision to 'WorldDynamic'")))));
-	};
-	if(!GetOwner()->GetComponentByClass(UPrimitiveComponent::StaticClass()))
+void UInteractBrush::DeactivateBrush()
+{
+	TransformUpdated.RemoveAll(this);
+	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->UnregisterBrush(this);
+	for (const auto InteractVolume : OverlappingInteractVolumes)
 	{
-		BrushCollisionWarning();
+		InteractVolume->RemoveBrush(this);
 	}
+	//Entered again by overlap query when activated again
+	OverlappingInteractVolumes.Reset();
+}
 
+bool UInteractBrush::HasVolumeCollision(const AActor* Actor)
+{
 	TArray<UPrimitiveComponent*> PrimitiveComponents;
-	GetOwner()->GetComponents<UPrimitiveComponent>(PrimitiveComponents);
-	bool bHasCollision = false;
+	Actor->GetComponents<UPrimitiveComponent>(PrimitiveComponents);
 	for (const auto& Comp : PrimitiveComponents)
 	{
 		if((Comp->GetCollisionEnabled()==ECollisionEnabled::QueryOnly || Comp->GetCollisionEnabled()==ECollisionEnabled::QueryAndPhysics)
 			&& Comp->GetCollisionResponseToChannel(ECollisionChannel::ECC_WorldDynamic)!= ECollisionResponse::ECR_Ignore)
 		{
-			bHasCollision = true;
-			break;
+			return true;
 		}
 	}
-	if (!bHasCollision)
-	{
-		BrushCollisionWarning();
-	}
-	GetOwner()->UpdateOverlaps();
+	return false;
+}
+
+void UInteractBrush::AddCollisionWarning() const
+{
+	//Check whether the Actor this Interact Brush attach to has collision with World Interact Volume
+	FMessageLog("PIE").Warning()
+	->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("Interact Brush: ")))))
+	->AddToken(FUObjectToken::Create(this))
+	->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("ISN'T attached to an Actor with Collisitn. Interact Volume will not work with it.")))))
+	->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("Please make Actor: ")))))
+	->AddToken(FUObjectToken::Create(this->GetOwner()))
+	->AddToken(FTextToken::Create(FText::FromString(FString(TEXT("has query collision to 'WorldDynamic'")))));
 }
 
 void UInteractBrush::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
-	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->UnregisterBrush(this);
-	for (const auto InteractVolume : OverlappingInteractVolumes)
-	{
-		InteractVolume->RemoveBrush(this);
-	}
+	DeactivateBrush();
+	InteractiveWorldSubsystem = nullptr;
 }
 
 void UInteractBrush::UpdateActiveState()
@@ -0,0 +1,72 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractCaptureBrush.h"
+
+#include "InteractiveWorldSubsystem.h"
+#include "WorldDrawingBoard.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+UInteractCaptureBrush::UInteractCaptureBrush()
+{
+	//Subsystem calls DrawBrush after capture
+	bDrawOnMovement = false;
+}
+
+FBox UInteractCaptureBrush::GetCaptureBounds() const
+{
+	const FVector Extent = FVector(Size.X * 0.5f, Size.Y * 0.5f, CaptureHeight);
+	return FBox(GetComponentLocation() - Extent, GetComponentLocation() + Extent);
+}
+
+void UInteractCaptureBrush::SetCaptureResult(UTextureRenderTarget2D* CaptureRT, const FBox& CaptureBounds)
+{
+	if (!BrushMaterial)
+	{
+		return;
+	}
+	if (!CaptureMaterial || CaptureMaterial->Parent != BrushMaterial)
+	{
+		CaptureMaterial = UMaterialInstanceDynamic::Create(BrushMaterial, this);
+	}
+	CaptureMaterial->SetTextureParameterValue(CaptureTextureParameterName, CaptureRT);
+
+	//Capture looks up with +X to the right,so +Y goes up in texture and V is flipped
+	const FBox BrushBounds = GetCaptureBounds();
+	const FVector CaptureSize = CaptureBounds.GetSize();
+	CapturedBrushBounds = FBox2D(FVector2D(BrushBounds.Min), FVector2D(BrushBounds.Max));
+	CoordinatePosition = FVector2D((BrushBounds.Min.X - CaptureBounds.Min.X) / CaptureSize.X,
+	                               (CaptureBounds.Max.Y - BrushBounds.Min.Y) / CaptureSize.Y);
+	CoordinateSize = FVector2D(Size.X / CaptureSize.X, -Size.Y / CaptureSize.Y);
+	DrawBrush();
+}
+
+void UInteractCaptureBrush::DrawOnBoardNative(AWorldDrawingBoard* DrawingBoard, float InterpolateRate,
+                                              int32 DrawTimes) const
+{
+	//Only one capture to draw,MultiDraw would draw it many times
+	if (!CaptureMaterial || !CapturedBrushBounds.bIsValid || InterpolateRate < 1)
+	{
+		return;
+	}
+	//Capture is aligned to world axes
+	FVector2D ScreenPosition;
+	FVector2D ScreenSize;
+	float ScreenRotation;
+	DrawingBoard->WorldToCanvasBrush(CapturedBrushBounds.GetCenter(), CapturedBrushBounds.GetSize(), 0,
+	                                 ScreenPosition, ScreenSize, ScreenRotation);
+	DrawingBoard->AddBrushInstance(CaptureMaterial, ScreenPosition, ScreenSize, CoordinatePosition, CoordinateSize,
+	                               ScreenRotation, FVector2D(0.5f, 0.5f));
+}
+
+void UInteractCaptureBrush::BeginPlay()
+{
+	Super::BeginPlay();
+	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->RegisterCaptureBrush(this);
+}
+
+void UInteractCaptureBrush::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->UnregisterCaptureBrush(this);
+	Super::EndPlay(EndPlayReason);
+}
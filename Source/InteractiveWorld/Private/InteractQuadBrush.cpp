@@ -0,0 +1,44 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractQuadBrush.h"
+
+#include "InteractiveWorldBPLibrary.h"
+#include "WorldDrawingBoard.h"
+
+UInteractQuadBrush::UInteractQuadBrush()
+{
+}
+
+void UInteractQuadBrush::DrawOnBoardNative(AWorldDrawingBoard* DrawingBoard, float InterpolateRate,
+                                           int32 DrawTimes) const
+{
+	if (!BrushMaterial)
+	{
+		return;
+	}
+	DrawingBoard->AddWorldStampInstance(MakeWorldStamp(InterpolateRate));
+}
+
+void UInteractQuadBrush::BuildWorldStamps_Implementation(float InterpolateRate, int32 DrawTimes)
+{
+	if (!BrushMaterial)
+	{
+		return;
+	}
+	AddWorldStamp(MakeWorldStamp(InterpolateRate));
+}
+
+FIWWorldStamp UInteractQuadBrush::MakeWorldStamp(float InterpolateRate) const
+{
+	//Interpolate from last update,for MultiDraw
+	FIWWorldStamp Stamp;
+	Stamp.Material = BrushMaterial;
+	Stamp.Location = FMath::Lerp(UInteractiveWorldBPLibrary::Vector3ToVector2(PreviousT.GetLocation()),
+	                             UInteractiveWorldBPLibrary::Vector3ToVector2(CurrentT.GetLocation()),
+	                             InterpolateRate);
+	const float PreviousYaw = PreviousT.Rotator().Yaw;
+	Stamp.Rotation = PreviousYaw + FRotator::NormalizeAxis(CurrentT.Rotator().Yaw - PreviousYaw) * InterpolateRate;
+	Stamp.Size = Size;
+	Stamp.VertexColor = VertexColor;
+	return Stamp;
+}
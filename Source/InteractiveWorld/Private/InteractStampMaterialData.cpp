@@ -0,0 +1,30 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractStampMaterialData.h"
+
+#include "Materials/MaterialInstance.h"
+
+bool UInteractStampMaterialData::IsAccumulative(const UMaterialInterface* Material)
+{
+	//Instances don't inherit user data of parents,so walk up the chain
+	while (Material)
+	{
+		const UInteractStampMaterialData* Data = const_cast<UMaterialInterface*>(Material)->GetAssetUserData<UInteractStampMaterialData>();
+		if (Data && Data->bAccumulative)
+		{
+			return true;
+		}
+		const UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(Material);
+		Material = MaterialInstance ? MaterialInstance->Parent : nullptr;
+	}
+	return false;
+}
+
+void UInteractStampMaterialData::CacheIsAccumulative(TMap<const UMaterialInterface*, bool>& Cache,
+                                                     const UMaterialInterface* Material)
+{
+	if (Material && !Cache.Contains(Material))
+	{
+		Cache.Add(Material, IsAccumulative(Material));
+	}
+}
@@ -2,6 +2,9 @@
 
 #include "InteractiveWorldBPLibrary.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "Engine/Canvas.h"
+#include "CanvasItem.h"
+#include "Kismet/KismetRenderingLibrary.h"
 
 UInteractiveWorldBPLibrary::UInteractiveWorldBPLibrary(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
@@ -17,6 +20,46 @@ void UInteractiveWorldBPLibrary::ResizeRenderTarget2D(UTextureRenderTarget2D* Re
 	}
 }
 
+//Draw Source stretched on whole Destination
+static void CopyRenderTarget(UObject* WorldContextObject, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination)
+{
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(WorldContextObject, Destination, CanvasDrawOn, CanvasSize, DrawContext);
+	FCanvasTileItem TileItem(FVector2D::ZeroVector, Source->GetResource(), CanvasSize, FLinearColor::White);
+	TileItem.BlendMode = SE_BLEND_Opaque;
+	CanvasDrawOn->DrawItem(TileItem);
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(WorldContextObject, DrawContext);
+}
+
+void UInteractiveWorldBPLibrary::ResizeRenderTarget2DKeepContent(UObject* WorldContextObject,
+                                                                 UTextureRenderTarget2D* RenderTarget2D, int32 SizeX,
+                                                                 int32 SizeY)
+{
+	if (!RenderTarget2D || SizeX <= 0 || SizeY <= 0 || (RenderTarget2D->SizeX == SizeX && RenderTarget2D->SizeY == SizeY))
+	{
+		return;
+	}
+	if (!RenderTarget2D->GetResource())
+	{
+		//Nothing to keep
+		RenderTarget2D->ResizeTarget(SizeX, SizeY);
+		return;
+	}
+	//Throwaway copy,not from the pool.It is only referenced here and freed by GC
+	UTextureRenderTarget2D* TempRenderTarget = UKismetRenderingLibrary::CreateRenderTarget2D(
+		WorldContextObject, RenderTarget2D->SizeX, RenderTarget2D->SizeY, RenderTarget2D->RenderTargetFormat, RenderTarget2D->ClearColor);
+	if (!TempRenderTarget)
+	{
+		RenderTarget2D->ResizeTarget(SizeX, SizeY);
+		return;
+	}
+	CopyRenderTarget(WorldContextObject, RenderTarget2D, TempRenderTarget);
+	RenderTarget2D->ResizeTarget(SizeX, SizeY);
+	CopyRenderTarget(WorldContextObject, TempRenderTarget, RenderTarget2D);
+}
+
 //Editor only!
 void UInteractiveWorldBPLibrary::RefreshInteractVolume(AWorldInteractVolume* InteractVolume)
 {
@@ -2,30 +2,386 @@
 
 
 #include "InteractiveWorldSubsystem.h"
+#include "InteractiveWorld.h"
 #include "InteractiveWorldBPLibrary.h"
-#include "Kismet/GameplayStatics.h"
+#include "InteractCaptureBrush.h"
+#include "InteractStampMaterialData.h"
+#include "WorldInteractVolume.h"
+#include "HAL/IConsoleManager.h"
+#include "WorldCollision.h"
+#include "Components/BrushComponent.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Kismet/KismetRenderingLibrary.h"
+#include "Async/ParallelFor.h"
+#include "Scalability.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
 
+static TAutoConsoleVariable<float> CVarIWRTScale(
+	TEXT("iw.RTScale"), 1.f,
+	TEXT("Scale RenderTargets of DrawingBoards that follow scalability,on top of effects quality"),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarIWMultiDrawDensity(
+	TEXT("iw.MultiDrawDensity"), 1.f,
+	TEXT("Scale draw times of brushes with MultiDraw,on top of effects quality"),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarIWGovernor(
+	TEXT("iw.Governor"), 0,
+	TEXT("Lower InteractiveWorld quality level when subsystem tick costs more than iw.GovernorBudgetMs,and raise it back when cheap"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarIWGovernorBudgetMs(
+	TEXT("iw.GovernorBudgetMs"), 2.f,
+	TEXT("Game thread budget of InteractiveWorld subsystem tick in milliseconds,for iw.Governor"),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GIWMemReportCommand(
+	TEXT("iw.MemReport"),
+	TEXT("Print memory of InteractiveWorld DrawingBoards,brushes and subsystem registries"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+		{
+			const UInteractiveWorldSubsystem* Subsystem = World ? World->GetSubsystem<UInteractiveWorldSubsystem>() : nullptr;
+			if (!Subsystem)
+			{
+				Ar.Logf(TEXT("No InteractiveWorldSubsystem in this world"));
+				return;
+			}
+			Subsystem->DumpMemoryReport(Ar);
+		}));
 
 void UInteractiveWorldSubsystem::Tick(float DeltaTime)
 {
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	UpdateScalability();
+	UpdateViewers();
+	DrainBrushRegistrations();
+	if (PendingActivationBrushes.Num() > 0)
+	{
+		ActivatePendingBrushes();
+	}
+	DeliverTraceResults();
+	if (CaptureBrushes.Num() > 0)
+	{
+		UpdateCaptures();
+	}
+	if (bEnableCPUWind)
+	{
+		UpdateWind(DeltaTime);
+	}
+	for (const auto DrawingBoard : DrawingBoards)
+	{
+		if (DrawingBoard)
+		{
+			DrawingBoard->UpdatePooledRenderTargets(DeltaTime);
+			DrawingBoard->UpdateRenderTargetScale(RTScale);
+		}
+	}
 	if (DrawingBoards.Num() > 0)
 	{
 		AllocateBrushes();
 	}
+	else
+	{
+		//No DrawingBoard to draw on,drop stamps
+		TakePendingStamps();
+	}
+	FlushCollectionParameters();
+	UpdateGovernor(DeltaTime, FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+}
+
+void UInteractiveWorldSubsystem::SetCollectionScalarParameter(UMaterialParameterCollection* Collection,
+                                                              FName ParameterName, float Value)
+{
+	SetCollectionParameter(Collection, ParameterName, true, FLinearColor(Value, 0, 0, 0));
+}
+
+void UInteractiveWorldSubsystem::SetCollectionVectorParameter(UMaterialParameterCollection* Collection,
+                                                              FName ParameterName, FLinearColor Value)
+{
+	SetCollectionParameter(Collection, ParameterName, false, Value);
+}
+
+void UInteractiveWorldSubsystem::SetCollectionParameter(UMaterialParameterCollection* Collection, FName ParameterName,
+                                                        bool bScalar, const FLinearColor& Value)
+{
+	if (!Collection || ParameterName.IsNone())
+	{
+		return;
+	}
+	const TPair<const UMaterialParameterCollection*, FName> Key(Collection, ParameterName);
+	int32* FoundIndex = CollectionParameterIndices.Find(Key);
+	if (!FoundIndex)
+	{
+		LLM_SCOPE_BYTAG(InteractiveWorld);
+		FIWCollectionParameter& NewParameter = CollectionParameters.AddDefaulted_GetRef();
+		NewParameter.Collection = Collection;
+		NewParameter.Name = ParameterName;
+		FoundIndex = &CollectionParameterIndices.Add(Key, CollectionParameters.Num() - 1);
+	}
+	FIWCollectionParameter& Parameter = CollectionParameters[*FoundIndex];
+	Parameter.bScalar = bScalar;
+	Parameter.Value = Value;
+	//Same as pushed,nothing to do unless a different value is waiting
+	if (!Parameter.bPending && Parameter.bPushed && Parameter.PushedValue == Value)
+	{
+		return;
+	}
+	if (!Parameter.bPending)
+	{
+		Parameter.bPending = true;
+		PendingCollectionParameters.Add(*FoundIndex);
+	}
+}
+
+void UInteractiveWorldSubsystem::FlushCollectionParameters()
+{
+	UWorld* World = GetWorld();
+	for (const int32 Index : PendingCollectionParameters)
+	{
+		FIWCollectionParameter& Parameter = CollectionParameters[Index];
+		Parameter.bPending = false;
+		if (Parameter.bPushed && Parameter.PushedValue == Parameter.Value)
+		{
+			continue;
+		}
+		UMaterialParameterCollection* Collection = Parameter.Collection.Get();
+		UMaterialParameterCollectionInstance* Instance = Collection && World ? World->GetParameterCollectionInstance(Collection) : nullptr;
+		if (!Instance)
+		{
+			continue;
+		}
+		if (Parameter.bScalar)
+		{
+			Instance->SetScalarParameterValue(Parameter.Name, Parameter.Value.R);
+		}
+		else
+		{
+			Instance->SetVectorParameterValue(Parameter.Name, Parameter.Value);
+		}
+		Parameter.PushedValue = Parameter.Value;
+		Parameter.bPushed = true;
+	}
+	PendingCollectionParameters.Reset();
+}
+
+int32 UInteractiveWorldSubsystem::GetQualityLevel() const
+{
+	const int32 EffectsQuality = Scalability::GetQualityLevels().EffectsQuality;
+	//0 is Low,4 is Cinematic
+	return FMath::Clamp(EffectsQuality - GovernorSteps, 0, 4);
+}
+
+//Value of quality level in table,last one for higher levels
+static float GetValueAtQualityLevel(const TArray<float>& Values, int32 QualityLevel)
+{
+	return Values.Num() > 0 ? Values[FMath::Min(QualityLevel, Values.Num() - 1)] : 1.f;
+}
+
+void UInteractiveWorldSubsystem::UpdateScalability()
+{
+	const int32 QualityLevel = GetQualityLevel();
+	RTScale = FMath::Clamp(GetValueAtQualityLevel(RTScalePerQualityLevel, QualityLevel) * CVarIWRTScale.GetValueOnGameThread(),
+	                       1.f / 16.f, 4.f);
+	MultiDrawDensity = FMath::Clamp(GetValueAtQualityLevel(MultiDrawDensityPerQualityLevel, QualityLevel)
+	                                * CVarIWMultiDrawDensity.GetValueOnGameThread(), 0.f, 16.f);
+}
+
+void UInteractiveWorldSubsystem::UpdateGovernor(float DeltaTime, float TickMs)
+{
+	if (CVarIWGovernor.GetValueOnGameThread() == 0)
+	{
+		GovernorSteps = 0;
+		SmoothedTickMs = TickMs;
+		return;
+	}
+	//Smooth over about half a second,so a single hitch doesn't change quality
+	SmoothedTickMs = FMath::Lerp(SmoothedTickMs, TickMs, FMath::Clamp(DeltaTime * 2.f, 0.f, 1.f));
+	GovernorCooldown -= DeltaTime;
+	if (GovernorCooldown > 0)
+	{
+		return;
+	}
+	const float BudgetMs = CVarIWGovernorBudgetMs.GetValueOnGameThread();
+	if (SmoothedTickMs > BudgetMs && GetQualityLevel() > 0)
+	{
+		GovernorSteps++;
+		GovernorCooldown = 1.f;
+	}
+	else if (SmoothedTickMs < BudgetMs * 0.5f && GovernorSteps > 0)
+	{
+		//Raise slowly,lower quality is cheaper so it would bounce back
+		GovernorSteps--;
+		GovernorCooldown = 5.f;
+	}
 }
 
 void UInteractiveWorldSubsystem::RegisterBrush(UInteractBrush* Brush)
 {
+	LLM_SCOPE_BYTAG(InteractiveWorld);
 	Brushes.AddUnique(Brush);
+	UpdateEveryFrameBrush(Brush);
+	if (Brush->bAffectCPUWind && !WindBrushes.Contains(Brush))
+	{
+		WindBrushes.Add(Brush);
+		WindBrushLocations.Add(Brush->GetComponentLocation());
+	}
+	//Draw once where it starts
+	MarkBrushDirty(Brush);
 	UE_LOG(LogTemp, Log, TEXT("%s Registered"), *Brush->GetName())
 }
 
 void UInteractiveWorldSubsystem::UnregisterBrush(UInteractBrush* Brush)
 {
+	PendingActivationBrushes.Remove(Brush);
 	Brushes.Remove(Brush);
+	EveryFrameBrushes.Remove(Brush);
+	DirtyBrushes.Remove(Brush);
+	SettlingBrushes.Remove(Brush);
+	const int32 WindBrushIndex = WindBrushes.Find(Brush);
+	if (WindBrushIndex != INDEX_NONE)
+	{
+		WindBrushes.RemoveAt(WindBrushIndex);
+		WindBrushLocations.RemoveAt(WindBrushIndex);
+	}
+	Brush->ClearDirty();
 	UE_LOG(LogTemp, Log, TEXT("%s UnRegistered"), *Brush->GetName())
 }
 
+void UInteractiveWorldSubsystem::QueueBrushActivation(UInteractBrush* Brush)
+{
+	PendingActivationBrushes.AddUnique(Brush);
+}
+
+void UInteractiveWorldSubsystem::ActivatePendingBrushes()
+{
+	const int32 NumToActivate = MaxBrushActivationsPerFrame > 0
+		                            ? FMath::Min(MaxBrushActivationsPerFrame, PendingActivationBrushes.Num())
+		                            : PendingActivationBrushes.Num();
+	TArray<UInteractBrush*, TInlineAllocator<64>> ActivatedBrushes;
+	//Owner bounds of ActivatedBrushes,same order
+	TArray<FBox, TInlineAllocator<64>> OwnerBounds;
+	for (int32 i = 0; i < NumToActivate; i++)
+	{
+		UInteractBrush* Brush = PendingActivationBrushes[i];
+		const AActor* Owner = Brush ? Brush->GetOwner() : nullptr;
+		if (!Owner)
+		{
+			continue;
+		}
+		Brush->ActivateBrush();
+		ActivatedBrushes.Add(Brush);
+		OwnerBounds.Add(Owner->GetComponentsBoundingBox());
+
+		//Actors of the same class have the same collision,only check and warn once
+		const TWeakObjectPtr<UClass> OwnerClass = Owner->GetClass();
+		if (!OwnerClassHasVolumeCollision.Contains(OwnerClass))
+		{
+			const bool bHasCollision = UInteractBrush::HasVolumeCollision(Owner);
+			OwnerClassHasVolumeCollision.Add(OwnerClass, bHasCollision);
+			if (!bHasCollision)
+			{
+				Brush->AddCollisionWarning();
+			}
+		}
+	}
+	PendingActivationBrushes.RemoveAt(0, NumToActivate, false);
+
+	//Cached overlap state of actors is not always filled when they spawn,like static actors of streamed levels
+	//or actors that generate overlap events later.So query once for each volume,instead of UpdateOverlaps for each actor
+	UWorld* World = GetWorld();
+	TArray<int32, TInlineAllocator<64>> CandidateIndices;
+	for (const auto InteractVolume : InteractVolumes)
+	{
+		const UBrushComponent* VolumeComponent = InteractVolume ? InteractVolume->GetBrushComponent() : nullptr;
+		if (!VolumeComponent || !VolumeComponent->GetGenerateOverlapEvents())
+		{
+			continue;
+		}
+		const FBox VolumeBounds = InteractVolume->GetComponentsBoundingBox();
+		CandidateIndices.Reset();
+		for (int32 i = 0; i < ActivatedBrushes.Num(); i++)
+		{
+			if (VolumeBounds.Intersect(OwnerBounds[i]))
+			{
+				CandidateIndices.Add(i);
+			}
+		}
+		if (CandidateIndices.Num() == 0)
+		{
+			continue;
+		}
+
+		FComponentQueryParams QueryParams(SCENE_QUERY_STAT(InteractVolumeActivateBrushes), InteractVolume);
+		VolumeOverlaps.Reset();
+		World->ComponentOverlapMulti(VolumeOverlaps, VolumeComponent, VolumeComponent->GetComponentLocation(),
+		                             VolumeComponent->GetComponentQuat(), QueryParams);
+		BrushesInVolume.Reset();
+		for (const FOverlapResult& Overlap : VolumeOverlaps)
+		{
+			const UPrimitiveComponent* OverlapComponent = Overlap.GetComponent();
+			if (!OverlapComponent || !OverlapComponent->GetGenerateOverlapEvents())
+			{
+				continue;
+			}
+			const AActor* OverlapActor = Overlap.GetActor();
+			for (const int32 Index : CandidateIndices)
+			{
+				UInteractBrush* Brush = ActivatedBrushes[Index];
+				if (Brush->GetOwner() == OverlapActor)
+				{
+					//An actor may overlap with several components
+					BrushesInVolume.AddUnique(Brush);
+				}
+			}
+		}
+		if (BrushesInVolume.Num() > 0)
+		{
+			InteractVolume->AddOverlappingBrushes(BrushesInVolume);
+		}
+	}
+}
+
+void UInteractiveWorldSubsystem::RegisterInteractVolume(AWorldInteractVolume* InteractVolume)
+{
+	InteractVolumes.AddUnique(InteractVolume);
+}
+
+void UInteractiveWorldSubsystem::UnregisterInteractVolume(AWorldInteractVolume* InteractVolume)
+{
+	InteractVolumes.Remove(InteractVolume);
+}
+
+void UInteractiveWorldSubsystem::MarkBrushDirty(UInteractBrush* Brush)
+{
+	if (Brush && Brush->TryMarkDirty())
+	{
+		DirtyBrushes.Add(Brush);
+	}
+}
+
+void UInteractiveWorldSubsystem::UpdateEveryFrameBrush(UInteractBrush* Brush)
+{
+	if (!Brush || !Brushes.Contains(Brush))
+	{
+		return;
+	}
+	if (Brush->bDrawEveryFrame)
+	{
+		EveryFrameBrushes.AddUnique(Brush);
+	}
+	else
+	{
+		EveryFrameBrushes.Remove(Brush);
+	}
+}
+
 void UInteractiveWorldSubsystem::RegisterDrawingBoard(AWorldDrawingBoard* DrawingBoard)
 {
 	DrawingBoards.AddUnique(DrawingBoard);
@@ -38,87 +394,609 @@ void UInteractiveWorldSubsystem::UnregisterDrawingBoard(AWorldDrawingBoard* Draw
 	UE_LOG(LogTemp, Log, TEXT("%s UnRegistered"), *DrawingBoard->GetName())
 }
 
-bool UInteractiveWorldSubsystem::PrepareBrushes(TArray<UInteractBrush*>& BrushesNeedDrawing)
+void UInteractiveWorldSubsystem::RequestTrace(UInteractBrush* Brush, const FVector& Start, const FVector& End,
+                                              ECollisionChannel TraceChannel)
 {
-	TArray<TSubclassOf<AWorldDrawingBoard>> NoVolumeDrawingBoardClass;
-	TArray<AWorldDrawingBoard*> InvalidDrawingBoard;
-	//Find DrawingBoards that do not use InteractVolumes
-	for (auto DrawingBoard : DrawingBoards)
+	UWorld* World = GetWorld();
+	if (!Brush || !World)
 	{
-		if (!DrawingBoard)
+		return;
+	}
+	//Trace is batched by world and runs on worker threads after this frame
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(InteractBrushTrace), false, Brush->GetOwner());
+	FIWPendingBrushTrace& Trace = RequestedTraces.AddDefaulted_GetRef();
+	Trace.Brush = Brush;
+	Trace.Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, TraceChannel, Params);
+	Trace.bOverlap = false;
+}
+
+void UInteractiveWorldSubsystem::RequestOverlap(UInteractBrush* Brush, const FVector& Location, float Radius,
+                                                ECollisionChannel TraceChannel)
+{
+	UWorld* World = GetWorld();
+	if (!Brush || !World)
+	{
+		return;
+	}
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(InteractBrushOverlap), false, Brush->GetOwner());
+	FIWPendingBrushTrace& Trace = RequestedTraces.AddDefaulted_GetRef();
+	Trace.Brush = Brush;
+	Trace.Handle = World->AsyncOverlapByChannel(Location, FQuat::Identity, TraceChannel,
+	                                            FCollisionShape::MakeSphere(Radius), Params);
+	Trace.bOverlap = true;
+}
+
+void UInteractiveWorldSubsystem::DeliverTraceResults()
+{
+	//Traces requested last tick are done now.Requests of this tick go to the next one
+	Swap(PendingTraces, RequestedTraces);
+	RequestedTraces.Reset();
+	//Brushes that didn't request last tick get no result this tick
+	TraceDeliveryFrame = GFrameCounter;
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		PendingTraces.Reset();
+		return;
+	}
+	for (const auto& Trace : PendingTraces)
+	{
+		UInteractBrush* Brush = Trace.Brush.Get();
+		if (!Brush)
 		{
-			InvalidDrawingBoard.Add(DrawingBoard);
 			continue;
 		}
-		if (!DrawingBoard->GetUseInteractVolume())
+		if (Trace.bOverlap)
 		{
-			NoVolumeDrawingBoardClass.Add(DrawingBoard->GetClass());
+			FOverlapDatum OverlapDatum;
+			const bool bValid = World->QueryOverlapData(Trace.Handle, OverlapDatum);
+			Brush->SetOverlapResult(bValid, bValid && OverlapDatum.OutOverlaps.Num() > 0);
+			continue;
 		}
+		FTraceDatum TraceDatum;
+		FIWBrushTraceResult Result;
+		Result.bValid = World->QueryTraceData(Trace.Handle, TraceDatum);
+		if (Result.bValid && TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit)
+		{
+			const FHitResult& Hit = TraceDatum.OutHits[0];
+			Result.bBlockingHit = true;
+			Result.ImpactPoint = Hit.ImpactPoint;
+			Result.ImpactNormal = Hit.ImpactNormal;
+			Result.Distance = Hit.Distance;
+		}
+		Brush->SetTraceResult(Result);
 	}
-	//Clear invalid DrawingBoards
-	for (auto DrawingBoard : InvalidDrawingBoard)
+	PendingTraces.Reset();
+}
+
+void UInteractiveWorldSubsystem::SetWindFieldCenter(FVector Center)
+{
+	WindFieldSolver.SetCenter(UInteractiveWorldBPLibrary::Vector3ToVector2(Center));
+}
+
+void UInteractiveWorldSubsystem::AddWindForce(FVector Location, FVector Velocity, float Radius)
+{
+	WindFieldSolver.AddForce(UInteractiveWorldBPLibrary::Vector3ToVector2(Location),
+	                         UInteractiveWorldBPLibrary::Vector3ToVector2(Velocity), Radius);
+}
+
+FVector UInteractiveWorldSubsystem::GetWindVelocity(FVector Location) const
+{
+	const FVector2D Velocity = WindFieldSolver.SampleVelocity(UInteractiveWorldBPLibrary::Vector3ToVector2(Location));
+	return FVector(Velocity, 0);
+}
+
+void UInteractiveWorldSubsystem::SampleWindVelocity(const TArray<FVector>& Locations, TArray<FVector>& OutVelocities) const
+{
+	OutVelocities.SetNumUninitialized(Locations.Num());
+	for (int32 i = 0; i < Locations.Num(); i++)
 	{
-		DrawingBoards.Remove(DrawingBoard);
+		const FVector2D Velocity = WindFieldSolver.SampleVelocity(UInteractiveWorldBPLibrary::Vector3ToVector2(Locations[i]));
+		OutVelocities[i] = FVector(Velocity, 0);
 	}
-	
-	bool bHasAnyBrushNeedDrawing = false;
-	BrushesNeedDrawing.Reset();
-	TArray<UInteractBrush*> InvalidBrushes;
-	
-	if (BrushCullDistance < 0)
+}
+
+void UInteractiveWorldSubsystem::UpdateWind(float DeltaTime)
+{
+	if (!WindFieldSolver.IsInitialized() || WindFieldSolver.GetGridSize() != WindGridSize
+		|| WindFieldSolver.GetCellSize() != WindCellSize)
+	{
+		WindFieldSolver.Initialize(WindGridSize, WindCellSize);
+	}
+	WindFieldSolver.TimeStep = WindTimeStep;
+	WindFieldSolver.Dissipation = WindDissipation;
+	WindFieldSolver.PressureIterations = WindPressureIterations;
+
+	if (bWindFollowCamera)
 	{
-		//No distance culling
-		for (auto Brush : Brushes)
+		//Follow primary viewer,dedicated server follows first remote player
+		if (ViewerSet.Num() > 0)
 		{
-			if (Brush)
-			{
-				if (Brush->PrepareForDrawing(NoVolumeDrawingBoardClass))
-				{
-					BrushesNeedDrawing.Add(Brush);
-					bHasAnyBrushNeedDrawing = true;
-				}
-			}
-			else
+			SetWindFieldCenter(ViewerSet.GetViewers()[0]);
+		}
+	}
+
+	//Moving brushes push wind with their velocity
+	for (int32 i = 0; i < WindBrushes.Num(); i++)
+	{
+		if (!WindBrushes[i])
+		{
+			continue;
+		}
+		const FVector Location = WindBrushes[i]->GetComponentLocation();
+		if (DeltaTime > 0)
+		{
+			const FVector Velocity = (Location - WindBrushLocations[i]) / DeltaTime;
+			if (Velocity.SizeSquared2D() > 1)
 			{
-				InvalidBrushes.Add(Brush);
+				AddWindForce(Location, Velocity, WindBrushes[i]->GetCullRadius());
 			}
 		}
+		WindBrushLocations[i] = Location;
 	}
-	else
+	const float DroppedTime = WindFieldSolver.GetDroppedTime();
+	WindFieldSolver.Update(DeltaTime);
+	const bool bDroppedTime = WindFieldSolver.GetDroppedTime() > DroppedTime;
+	if (bDroppedTime && !bWindDroppingTime)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CPU wind can't catch up,time over %d steps per update is dropped.Raise WindTimeStep or lower WindPressureIterations"),
+		       WindFieldSolver.MaxStepsPerUpdate);
+	}
+	bWindDroppingTime = bDroppedTime;
+}
+
+void UInteractiveWorldSubsystem::RegisterCaptureBrush(UInteractCaptureBrush* Brush)
+{
+	CaptureBrushes.AddUnique(Brush);
+}
+
+void UInteractiveWorldSubsystem::UnregisterCaptureBrush(UInteractCaptureBrush* Brush)
+{
+	CaptureBrushes.Remove(Brush);
+	CaptureScheduler.Remove(Brush->GetUniqueID());
+}
+
+void UInteractiveWorldSubsystem::UpdateCaptures()
+{
+	CaptureScheduler.MaxCapturesPerFrame = MaxCapturesPerFrame;
+	CaptureScheduler.MaxCaptureSize = MaxCaptureSize;
+	CaptureScheduler.MergeDistance = CaptureMergeDistance;
+	CaptureScheduler.IntervalDistance = CaptureIntervalDistance;
+	CaptureScheduler.MaxInterval = MaxCaptureInterval;
+
+	const FIWViewerSet* Viewers = nullptr;
+	const bool bUseCulling = GetBrushCullViewers(Viewers);
+	CaptureRequests.Reset();
+	//Brush of each request,same order
+	TArray<UInteractCaptureBrush*, TInlineAllocator<16>> RequestBrushes;
+	for (const auto Brush : CaptureBrushes)
+	{
+		if (!Brush)
+		{
+			continue;
+		}
+		if (bUseCulling && !Viewers->IsInRange(Brush->GetComponentLocation(), Brush->GetCullRadius()))
+		{
+			continue;
+		}
+		FIWCaptureRequest& Request = CaptureRequests.AddDefaulted_GetRef();
+		Request.Id = Brush->GetUniqueID();
+		Request.Bounds = Brush->GetCaptureBounds();
+		Request.ViewDistance = bUseCulling ? Viewers->GetNearestDistance(Brush->GetComponentLocation()) : 0;
+		RequestBrushes.Add(Brush);
+	}
+	CaptureScheduler.Schedule(CaptureRequests, CaptureJobs);
+	if (CaptureJobs.Num() == 0)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < CaptureJobs.Num(); i++)
+	{
+		const FIWCaptureJob& Job = CaptureJobs[i];
+		USceneCaptureComponent2D* Capture = GetCaptureComponent(i);
+		//Look up from bottom of bounds with +X to the right,depth is height above bottom
+		Capture->SetWorldLocationAndRotation(FVector(Job.Bounds.GetCenter().X, Job.Bounds.GetCenter().Y, Job.Bounds.Min.Z),
+		                                     FRotator(90, -90, 0));
+		Capture->OrthoWidth = Job.Bounds.Max.X - Job.Bounds.Min.X;
+		Capture->MaxViewDistanceOverride = Job.Bounds.Max.Z - Job.Bounds.Min.Z;
+		Capture->ShowOnlyActors.Reset();
+		for (const int32 Index : Job.RequestIndices)
+		{
+			Capture->ShowOnlyActors.AddUnique(RequestBrushes[Index]->GetOwner());
+		}
+		Capture->CaptureScene();
+		for (const int32 Index : Job.RequestIndices)
+		{
+			RequestBrushes[Index]->SetCaptureResult(Capture->TextureTarget, Job.Bounds);
+		}
+	}
+}
+
+USceneCaptureComponent2D* UInteractiveWorldSubsystem::GetCaptureComponent(int32 Index)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	while (CaptureComponents.Num() <= Index)
+	{
+		USceneCaptureComponent2D* Capture = NewObject<USceneCaptureComponent2D>(this);
+		Capture->ProjectionType = ECameraProjectionMode::Orthographic;
+		Capture->CaptureSource = ESceneCaptureSource::SCS_SceneDepth;
+		Capture->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
+		Capture->bCaptureEveryFrame = false;
+		Capture->bCaptureOnMovement = false;
+		Capture->TextureTarget = UKismetRenderingLibrary::CreateRenderTarget2D(this, CaptureResolution, CaptureResolution, RTF_R16f);
+		Capture->RegisterComponentWithWorld(GetWorld());
+		CaptureComponents.Add(Capture);
+	}
+	USceneCaptureComponent2D* Capture = CaptureComponents[Index];
+	if (Capture->TextureTarget->SizeX != CaptureResolution)
+	{
+		Capture->TextureTarget->ResizeTarget(CaptureResolution, CaptureResolution);
+	}
+	return Capture;
+}
+
+UTextureRenderTarget2D* UInteractiveWorldSubsystem::AcquireRenderTarget(int32 SizeX, int32 SizeY,
+                                                                       ETextureRenderTargetFormat Format,
+                                                                       FLinearColor ClearColor)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	UTextureRenderTarget2D* RenderTarget = nullptr;
+	for (int32 i = 0; i < PooledRenderTargets.Num(); i++)
+	{
+		const UTextureRenderTarget2D* PooledRenderTarget = PooledRenderTargets[i];
+		if (PooledRenderTarget && PooledRenderTarget->SizeX == SizeX && PooledRenderTarget->SizeY == SizeY
+			&& PooledRenderTarget->RenderTargetFormat == Format)
+		{
+			RenderTarget = PooledRenderTargets[i];
+			PooledRenderTargets.RemoveAtSwap(i);
+			break;
+		}
+	}
+	if (!RenderTarget)
+	{
+		return UKismetRenderingLibrary::CreateRenderTarget2D(this, SizeX, SizeY, Format, ClearColor);
+	}
+	//Content of last owner should not be seen
+	RenderTarget->ClearColor = ClearColor;
+	UKismetRenderingLibrary::ClearRenderTarget2D(this, RenderTarget, ClearColor);
+	return RenderTarget;
+}
+
+void UInteractiveWorldSubsystem::ReleaseRenderTarget(UTextureRenderTarget2D* RenderTarget)
+{
+	if (!RenderTarget)
+	{
+		return;
+	}
+	//Pool is full,drop it.Materials may still reference it,so GC frees it instead of releasing resource here
+	if (PooledRenderTargets.Num() < MaxPooledRenderTargets)
+	{
+		PooledRenderTargets.AddUnique(RenderTarget);
+	}
+}
+
+void UInteractiveWorldSubsystem::SubmitStamps(UMaterialInterface* Material,
+                                               TSubclassOf<AWorldDrawingBoard> DrawingBoardClass,
+                                               TArray<FIWStamp>&& Stamps)
+{
+	if (!Material || Stamps.Num() == 0)
+	{
+		return;
+	}
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	NumQueuedStamps += Stamps.Num();
+	FIWStampBatch* Batch = QueuedStampBatches.AllocateItem();
+	Batch->Material = Material;
+	Batch->DrawingBoardClass = DrawingBoardClass;
+	Batch->Stamps = MoveTemp(Stamps);
+	QueuedStampBatches.Push(Batch);
+}
+
+FIWStampBatch* UInteractiveWorldSubsystem::AllocateStampBatch(UMaterialInterface* Material,
+                                                              TSubclassOf<AWorldDrawingBoard> DrawingBoardClass)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	FIWStampBatch* Batch = QueuedStampBatches.AllocateItem();
+	Batch->Material = Material;
+	Batch->DrawingBoardClass = DrawingBoardClass;
+	Batch->Stamps.Reset();
+	return Batch;
+}
+
+void UInteractiveWorldSubsystem::SubmitStampBatch(FIWStampBatch* Batch)
+{
+	//Pushed even if empty,so the batch is recycled
+	NumQueuedStamps += Batch->Stamps.Num();
+	QueuedStampBatches.Push(Batch);
+}
+
+void UInteractiveWorldSubsystem::SubmitStamp(UMaterialInterface* Material,
+                                              TSubclassOf<AWorldDrawingBoard> DrawingBoardClass,
+                                              const FIWStamp& Stamp)
+{
+	if (!Material)
+	{
+		return;
+	}
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	NumQueuedStamps++;
+	FIWQueuedStamp* QueuedStamp = QueuedStamps.AllocateItem();
+	QueuedStamp->Material = Material;
+	QueuedStamp->DrawingBoardClass = DrawingBoardClass;
+	QueuedStamp->Stamp = Stamp;
+	QueuedStamps.Push(QueuedStamp);
+}
+
+void UInteractiveWorldSubsystem::AddStamps(UMaterialInterface* Material,
+                                           TSubclassOf<AWorldDrawingBoard> DrawingBoardClass,
+                                           const TArray<FIWStamp>& Stamps)
+{
+	TArray<FIWStamp> StampsCopy = Stamps;
+	SubmitStamps(Material, DrawingBoardClass, MoveTemp(StampsCopy));
+}
+
+FIWStampBatch& UInteractiveWorldSubsystem::FindOrAddDrawingStampBatch(const TWeakObjectPtr<UMaterialInterface>& Material,
+                                                                      TSubclassOf<AWorldDrawingBoard> DrawingBoardClass)
+{
+	//Only one batch for each material and DrawingBoard class
+	for (auto& Batch : DrawingStampBatches)
+	{
+		if (Batch.Material == Material && Batch.DrawingBoardClass == DrawingBoardClass)
+		{
+			return Batch;
+		}
+	}
+	FIWStampBatch& NewBatch = DrawingStampBatches.AddDefaulted_GetRef();
+	NewBatch.Material = Material;
+	NewBatch.DrawingBoardClass = DrawingBoardClass;
+	return NewBatch;
+}
+
+bool UInteractiveWorldSubsystem::TakePendingStamps()
+{
+	//Keep batches and their memory for next tick,batches that got no stamp in last tick are freed
+	DrawingStampBatches.RemoveAll([](const FIWStampBatch& Batch) { return Batch.Stamps.Num() == 0; });
+	for (auto& Batch : DrawingStampBatches)
+	{
+		Batch.Stamps.Reset();
+	}
+	//Producers may push while draining,so only subtract what was taken
+	int32 NumTakenStamps = 0;
+	//Always append,moving a queued array in would throw away memory the batch kept
+	QueuedStampBatches.Drain([this, &NumTakenStamps](FIWStampBatch& QueuedBatch)
+	{
+		NumTakenStamps += QueuedBatch.Stamps.Num();
+		FindOrAddDrawingStampBatch(QueuedBatch.Material, QueuedBatch.DrawingBoardClass).Stamps.Append(QueuedBatch.Stamps);
+		QueuedBatch.Stamps.Reset();
+	});
+	QueuedStamps.Drain([this, &NumTakenStamps](const FIWQueuedStamp& QueuedStamp)
+	{
+		FindOrAddDrawingStampBatch(QueuedStamp.Material, QueuedStamp.DrawingBoardClass).Stamps.Add(QueuedStamp.Stamp);
+		NumTakenStamps++;
+	});
+	NumQueuedStamps -= NumTakenStamps;
+	return DrawingStampBatches.ContainsByPredicate([](const FIWStampBatch& Batch) { return Batch.Stamps.Num() > 0; });
+}
+
+void UInteractiveWorldSubsystem::RequestRegisterBrush(UInteractBrush* Brush)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	FIWBrushRegistration* Registration = QueuedBrushRegistrations.AllocateItem();
+	Registration->Brush = Brush;
+	Registration->BrushKey = Brush;
+	Registration->bRegister = true;
+	QueuedBrushRegistrations.Push(Registration);
+}
+
+void UInteractiveWorldSubsystem::RequestUnregisterBrush(UInteractBrush* Brush)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	FIWBrushRegistration* Registration = QueuedBrushRegistrations.AllocateItem();
+	Registration->Brush = Brush;
+	Registration->BrushKey = Brush;
+	Registration->bRegister = false;
+	QueuedBrushRegistrations.Push(Registration);
+}
+
+void UInteractiveWorldSubsystem::DrainBrushRegistrations()
+{
+	QueuedBrushRegistrations.Drain([this](const FIWBrushRegistration& Registration)
 	{
-		//Use distance culling
-		const FVector CameraLocation = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0)->GetCameraLocation();
-		for (auto Brush : Brushes)
+		UInteractBrush* Brush = Registration.Brush.Get();
+		if (!Brush)
 		{
-			if (Brush)
+			//Registering a destroyed brush is dropped,unregistering it must still remove it
+			if (!Registration.bRegister)
 			{
-				if (FVector::DistXY(CameraLocation, Brush->GetComponentLocation()) <= BrushCullDistance + Brush->
-					GetCullRadius()
-					&& Brush->PrepareForDrawing(NoVolumeDrawingBoardClass))
-				{
-					BrushesNeedDrawing.Add(Brush);
-					bHasAnyBrushNeedDrawing = true;
-				}
+				RemoveDestroyedBrush(Registration.BrushKey);
 			}
-			else
+			return;
+		}
+		//Same path as brushes of game thread,so transform is bound and volume state is resolved
+		if (Registration.bRegister)
+		{
+			if (!Brushes.Contains(Brush))
 			{
-				InvalidBrushes.Add(Brush);
+				QueueBrushActivation(Brush);
 			}
 		}
+		else
+		{
+			Brush->DeactivateBrush();
+		}
+	});
+}
+
+void UInteractiveWorldSubsystem::RemoveDestroyedBrush(UInteractBrush* BrushKey)
+{
+	auto IsDestroyed = [BrushKey](const UInteractBrush* Brush) { return !Brush || Brush == BrushKey; };
+	PendingActivationBrushes.RemoveAll(IsDestroyed);
+	Brushes.RemoveAll(IsDestroyed);
+	EveryFrameBrushes.RemoveAll(IsDestroyed);
+	DirtyBrushes.RemoveAll(IsDestroyed);
+	SettlingBrushes.RemoveAll(IsDestroyed);
+	for (int32 i = WindBrushes.Num() - 1; i >= 0; i--)
+	{
+		if (IsDestroyed(WindBrushes[i]))
+		{
+			WindBrushes.RemoveAt(i);
+			WindBrushLocations.RemoveAt(i);
+		}
 	}
-	for (auto BrushToRemove : InvalidBrushes)
+}
+
+void UInteractiveWorldSubsystem::AllocateStamps(AWorldDrawingBoard* DrawingBoard)
+{
+	for (const auto& Batch : DrawingStampBatches)
 	{
-		Brushes.Remove(BrushToRemove);
+		if (!Batch.DrawingBoardClass || DrawingBoard->IsA(Batch.DrawingBoardClass))
+		{
+			DrawingBoard->AddStampInstances(Batch.Material.Get(), Batch.Stamps);
+		}
 	}
-	return bHasAnyBrushNeedDrawing;
 }
 
+bool UInteractiveWorldSubsystem::GetBrushCullViewers(const FIWViewerSet*& OutViewers) const
+{
+	//Without any viewer there is nothing to cull around,draw everything like before
+	if (BrushCullDistance < 0 || ViewerSet.Num() == 0)
+	{
+		return false;
+	}
+	OutViewers = &ViewerSet;
+	return true;
+}
+
+void UInteractiveWorldSubsystem::RegisterViewer(AActor* Viewer)
+{
+	if (Viewer)
+	{
+		CustomViewers.AddUnique(Viewer);
+	}
+}
+
+void UInteractiveWorldSubsystem::UnregisterViewer(AActor* Viewer)
+{
+	CustomViewers.Remove(Viewer);
+}
+
+void UInteractiveWorldSubsystem::UpdateViewers()
+{
+	ViewerSet.Reset(BrushCullDistance);
+	//Local players first,so the first viewer is the primary camera.Replay spectator is a local player too
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			ViewerSet.AddViewer(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+	}
+	//Remote players on server,their cameras are not updated here so use view targets
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && !PlayerController->IsLocalController())
+		{
+			if (const AActor* ViewTarget = PlayerController->GetViewTarget())
+			{
+				ViewerSet.AddViewer(ViewTarget->GetActorLocation());
+			}
+		}
+	}
+	CustomViewers.RemoveAll([](const TWeakObjectPtr<AActor>& Viewer) { return !Viewer.IsValid(); });
+	for (const auto& Viewer : CustomViewers)
+	{
+		ViewerSet.AddViewer(Viewer->GetActorLocation());
+	}
+	ViewerSet.Build();
+}
+
+bool UInteractiveWorldSubsystem::PrepareBrushes(TArray<UInteractBrush*>& OutBrushesNeedDrawing)
+{
+	//Clear invalid DrawingBoards
+	DrawingBoards.RemoveAll([](const AWorldDrawingBoard* DrawingBoard) { return !DrawingBoard; });
+	//Find DrawingBoards that do not use InteractVolumes
+	NoVolumeDrawingBoardClasses.Reset();
+	for (auto DrawingBoard : DrawingBoards)
+	{
+		if (!DrawingBoard->GetUseInteractVolume())
+		{
+			NoVolumeDrawingBoardClasses.Add(DrawingBoard->GetClass());
+		}
+	}
+	
+	bool bHasAnyBrushNeedDrawing = false;
+	OutBrushesNeedDrawing.Reset();
+
+	//Only brushes that moved,draw every frame or called DrawBrush are visited,still brushes cost nothing
+	//Brushes dirty in this tick settle in next tick,so PreviousT catches up with CurrentT like polling did
+	BrushesToPrepare.Reset();
+	Swap(BrushesToPrepare, DirtyBrushes);
+	for (const auto Brush : EveryFrameBrushes)
+	{
+		if (Brush && Brush->TryMarkDirty())
+		{
+			BrushesToPrepare.Add(Brush);
+		}
+	}
+	const int32 NumMovedBrushes = BrushesToPrepare.Num();
+	for (const auto Brush : SettlingBrushes)
+	{
+		if (Brush && Brush->TryMarkDirty())
+		{
+			BrushesToPrepare.Add(Brush);
+		}
+	}
+	SettlingBrushes.Reset();
+	for (int32 i = 0; i < NumMovedBrushes; i++)
+	{
+		if (BrushesToPrepare[i] && !BrushesToPrepare[i]->bDrawEveryFrame)
+		{
+			SettlingBrushes.Add(BrushesToPrepare[i]);
+		}
+	}
+
+	//Use distance culling
+	const FIWViewerSet* Viewers = nullptr;
+	const bool bUseCulling = GetBrushCullViewers(Viewers);
+	for (const auto Brush : BrushesToPrepare)
+	{
+		if (!Brush)
+		{
+			continue;
+		}
+		Brush->ClearDirty();
+		if (bUseCulling && !Viewers->IsInRange(Brush->GetComponentLocation(), Brush->GetCullRadius()))
+		{
+			continue;
+		}
+		if (Brush->PrepareForDrawing(NoVolumeDrawingBoardClasses))
+		{
+			OutBrushesNeedDrawing.Add(Brush);
+			bHasAnyBrushNeedDrawing = true;
+		}
+	}
+	return bHasAnyBrushNeedDrawing;
+}
 void UInteractiveWorldSubsystem::AllocateBrushes()
 {
-	TArray<UInteractBrush*> BrushesNeedDrawing;
-	if (PrepareBrushes(BrushesNeedDrawing))
+	const bool bHasAnyBrushNeedDrawing = PrepareBrushes(BrushesNeedDrawing);
+	const bool bHasAnyStamp = TakePendingStamps();
+	if (bHasAnyBrushNeedDrawing || bHasAnyStamp)
 	{
-		TArray<UInteractBrush*> BrushesForDrawingBoard;
+		//Brushes that cache world stamps build them once on game thread,DrawingBoards only transform them
+		for (const auto Brush : BrushesNeedDrawing)
+		{
+			if (Brush->bCacheWorldStamps)
+			{
+				Brush->BuildWorldStampCache();
+			}
+		}
+
+		//Allocate on game thread,DrawingBoards may update state in Blueprint
+		AllocatedDrawingBoards.Reset();
 		for (const auto DrawingBoard : DrawingBoards)
 		{
 			if (!DrawingBoard->GetActiveState())
@@ -128,6 +1006,12 @@ void UInteractiveWorldSubsystem::AllocateBrushes()
 			}
 			//Update location before we allocate,so that the DrawingBoard range culling will be correct
 			DrawingBoard->UpdateDrawingBoardState();
+			if (AllocatedBrushes.Num() <= AllocatedDrawingBoards.Num())
+			{
+				AllocatedBrushes.AddDefaulted();
+			}
+			TArray<UInteractBrush*>& BrushesForDrawingBoard = AllocatedBrushes[AllocatedDrawingBoards.Num()];
+			AllocatedDrawingBoards.Add(DrawingBoard);
 			BrushesForDrawingBoard.Reset();
 			if (DrawingBoard->GetShouldDrawOn())
 			{
@@ -142,8 +1026,45 @@ void UInteractiveWorldSubsystem::AllocateBrushes()
 						BrushesForDrawingBoard.Add(Brush);
 					}
 				}
+				AllocateStamps(DrawingBoard);
 			}
-			DrawingBoard->PrepareForSimulate(BrushesForDrawingBoard);
+		}
+
+		//Native brushes build instances for all DrawingBoards on worker threads
+		const bool bHasAnyParallelBrush = bParallelBuildInstances && BrushesNeedDrawing.ContainsByPredicate(
+			[](const UInteractBrush* Brush) { return Brush->CanDrawInParallel(); });
+		if (bHasAnyParallelBrush)
+		{
+			//Material asset user data is read here,worker threads only look it up
+			AccumulativeMaterials.Reset();
+			for (const auto Brush : BrushesNeedDrawing)
+			{
+				if (Brush->HasWorldStampCache())
+				{
+					for (const FIWWorldStamp& Stamp : Brush->GetWorldStamps())
+					{
+						UInteractStampMaterialData::CacheIsAccumulative(AccumulativeMaterials, Stamp.Material);
+					}
+				}
+			}
+			for (const auto DrawingBoard : AllocatedDrawingBoards)
+			{
+				DrawingBoard->CacheAccumulativeMaterials(AccumulativeMaterials);
+			}
+
+			ParallelFor(AllocatedDrawingBoards.Num(), [this](int32 Index)
+			{
+				if (AllocatedBrushes[Index].Num() > 0)
+				{
+					AllocatedDrawingBoards[Index]->BuildParallelInstances(AllocatedBrushes[Index], AccumulativeMaterials);
+				}
+			});
+		}
+
+		//Blueprint brushes and canvases are done on game thread
+		for (int32 i = 0; i < AllocatedDrawingBoards.Num(); i++)
+		{
+			AllocatedDrawingBoards[i]->PrepareForSimulate(AllocatedBrushes[i]);
 		}
 		for (const auto Brush : BrushesNeedDrawing)
 		{
@@ -161,8 +1082,131 @@ void UInteractiveWorldSubsystem::AllocateBrushes()
 	}
 }
 
+//GPU bytes of a RenderTarget,0 if its resource is released
+static int64 GetRenderTargetBytes(const UTextureRenderTarget2D* RenderTarget)
+{
+	return RenderTarget && RenderTarget->GetResource() ? RenderTarget->CalcTextureMemorySizeEnum(TMC_ResidentMips) : 0;
+}
+
+void UInteractiveWorldSubsystem::DumpMemoryReport(FOutputDevice& Ar) const
+{
+	constexpr double KB = 1024.0;
+	Ar.Logf(TEXT("InteractiveWorld memory report of %s"), *GetNameSafe(GetWorld()));
+	Ar.Logf(TEXT("Quality level: %d,governor steps: %d,RT scale: %.2f,MultiDraw density: %.2f,tick: %.2f ms"),
+	        GetQualityLevel(), GovernorSteps, RTScale, MultiDrawDensity, SmoothedTickMs);
+
+	//DrawingBoards
+	int64 TotalRenderTargetBytes = 0;
+	int64 TotalInstanceBufferBytes = 0;
+	Ar.Logf(TEXT("DrawingBoards: %d"), DrawingBoards.Num());
+	for (const auto DrawingBoard : DrawingBoards)
+	{
+		if (!DrawingBoard)
+		{
+			continue;
+		}
+		FIWDrawingBoardMemoryStats Stats;
+		DrawingBoard->GetMemoryStats(Stats);
+		TotalRenderTargetBytes += Stats.RenderTargetBytes;
+		TotalInstanceBufferBytes += Stats.InstanceBufferBytes;
+		Ar.Logf(TEXT("  %s (%s) %s,%.1fs from last draw,pooled RTs %s"),
+		        *DrawingBoard->GetName(), *DrawingBoard->GetClass()->GetName(),
+		        Stats.bSimulating ? TEXT("Simulating") : TEXT("Sleeping"), Stats.TimeFromLastDraw,
+		        Stats.bRenderTargetsAcquired ? TEXT("acquired") : TEXT("released"));
+		Ar.Logf(TEXT("    RenderTargets: %d,%.1f KB"), Stats.NumRenderTargets, Stats.RenderTargetBytes / KB);
+		Ar.Logf(TEXT("    Instance buffers: %.1f KB,%d pending triangles,%d peak triangles"),
+		        Stats.InstanceBufferBytes / KB, Stats.PendingTriangles, Stats.PeakTriangles);
+		Ar.Logf(TEXT("    Saved content: %.1f KB,baked tiles: %d,%.1f KB,dirty rects: %d"),
+		        Stats.SavedContentBytes / KB, Stats.NumBakedTiles, Stats.BakedTileBytes / KB, Stats.NumDirtyRects);
+	}
+
+	//Brushes
+	TMap<const UClass*, int32> BrushesPerClass;
+	for (const auto Brush : Brushes)
+	{
+		if (Brush)
+		{
+			BrushesPerClass.FindOrAdd(Brush->GetClass())++;
+		}
+	}
+	Ar.Logf(TEXT("Brushes: %d,every frame: %d,dirty: %d,settling: %d,wind: %d,capture: %d"),
+	        Brushes.Num(), EveryFrameBrushes.Num(), DirtyBrushes.Num(), SettlingBrushes.Num(),
+	        WindBrushes.Num(), CaptureBrushes.Num());
+	for (const auto& Elem : BrushesPerClass)
+	{
+		Ar.Logf(TEXT("  %s: %d"), *Elem.Key->GetName(), Elem.Value);
+	}
+
+	//Registries and scratch arrays
+	int64 AllocatedBrushesBytes = AllocatedBrushes.GetAllocatedSize();
+	for (const auto& BrushesForDrawingBoard : AllocatedBrushes)
+	{
+		AllocatedBrushesBytes += BrushesForDrawingBoard.GetAllocatedSize();
+	}
+	const int64 RegistryBytes = Brushes.GetAllocatedSize() + EveryFrameBrushes.GetAllocatedSize()
+		+ DirtyBrushes.GetAllocatedSize() + SettlingBrushes.GetAllocatedSize() + BrushesToPrepare.GetAllocatedSize()
+		+ DrawingBoards.GetAllocatedSize() + AllocatedDrawingBoards.GetAllocatedSize() + AllocatedBrushesBytes
+		+ WindBrushes.GetAllocatedSize() + WindBrushLocations.GetAllocatedSize() + CaptureBrushes.GetAllocatedSize()
+		+ CaptureRequests.GetAllocatedSize() + CaptureJobs.GetAllocatedSize()
+		+ PendingTraces.GetAllocatedSize() + RequestedTraces.GetAllocatedSize();
+	Ar.Logf(TEXT("Registries: %.1f KB"), RegistryBytes / KB);
+	Ar.Logf(TEXT("Traces: %d pending,%d requested"), PendingTraces.Num(), RequestedTraces.Num());
+
+	Ar.Logf(TEXT("Stamps: %d queued"), NumQueuedStamps.load());
+
+	int64 PooledBytes = 0;
+	for (const auto RenderTarget : PooledRenderTargets)
+	{
+		PooledBytes += GetRenderTargetBytes(RenderTarget);
+	}
+	TotalRenderTargetBytes += PooledBytes;
+	Ar.Logf(TEXT("Render target pool: %d idle,%.1f KB"), PooledRenderTargets.Num(), PooledBytes / KB);
+
+	int64 CaptureBytes = 0;
+	for (const auto Capture : CaptureComponents)
+	{
+		CaptureBytes += Capture ? GetRenderTargetBytes(Capture->TextureTarget) : 0;
+	}
+	TotalRenderTargetBytes += CaptureBytes;
+	Ar.Logf(TEXT("Scene captures: %d,%.1f KB"), CaptureComponents.Num(), CaptureBytes / KB);
+	Ar.Logf(TEXT("CPU wind: %s,%.1f KB,%.2f s dropped"), bEnableCPUWind ? TEXT("enabled") : TEXT("disabled"),
+	        WindFieldSolver.GetAllocatedSize() / KB, WindFieldSolver.GetDroppedTime());
+
+	//Volumes
+	Ar.Logf(TEXT("Brushes waiting for activation: %d"), PendingActivationBrushes.Num());
+	Ar.Logf(TEXT("Viewers: %d,%d registered"), ViewerSet.Num(), CustomViewers.Num());
+	Ar.Logf(TEXT("Collection parameters: %d,%d pending"), CollectionParameters.Num(), PendingCollectionParameters.Num());
+	for (const auto InteractVolume : InteractVolumes)
+	{
+		if (InteractVolume)
+		{
+			Ar.Logf(TEXT("Volume %s %s,overlapping brushes: %d,manual brushes: %d,DrawingBoards: %d"),
+			        *InteractVolume->GetName(), InteractVolume->GetVolumeActive() ? TEXT("active") : TEXT("inactive"),
+			        InteractVolume->GetNumOverlappingBrushes(), InteractVolume->GetNumManualAddingBrushes(),
+			        InteractVolume->GetDrawingBoards().Num());
+		}
+	}
+
+	Ar.Logf(TEXT("Total render targets: %.1f KB,instance buffers: %.1f KB"),
+	        TotalRenderTargetBytes / KB, TotalInstanceBufferBytes / KB);
+}
+
 void UInteractiveWorldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 {
 	Super::OnWorldBeginPlay(InWorld);
 	
 }
+
+void UInteractiveWorldSubsystem::Deinitialize()
+{
+	for (const auto Capture : CaptureComponents)
+	{
+		if (Capture)
+		{
+			Capture->DestroyComponent();
+		}
+	}
+	CaptureComponents.Empty();
+	CaptureScheduler.Reset();
+	Super::Deinitialize();
+}
@@ -0,0 +1,181 @@
+// Copyright 2023 Sun BoHeng
+
+#include "NiagaraDataInterfaceInteractStamp.h"
+
+#include "InteractiveWorld.h"
+#include "InteractiveWorldSubsystem.h"
+#include "NiagaraSystemInstance.h"
+#include "NiagaraTypes.h"
+
+#define LOCTEXT_NAMESPACE "NiagaraDataInterfaceInteractStamp"
+
+static const FName AddStampName(TEXT("AddStamp"));
+
+UNiagaraDataInterfaceInteractStamp::UNiagaraDataInterfaceInteractStamp(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+void UNiagaraDataInterfaceInteractStamp::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	//Register this DI as a type,so that it can be used as a parameter
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		const ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+}
+
+void UNiagaraDataInterfaceInteractStamp::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+	FNiagaraFunctionSignature Sig;
+	Sig.Name = AddStampName;
+	Sig.bMemberFunction = true;
+	Sig.bRequiresContext = false;
+	Sig.bRequiresExecPin = true;
+	Sig.bSupportsGPU = false;
+	Sig.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition(GetClass()), TEXT("InteractStamp")));
+	Sig.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Execute")));
+	Sig.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec3Def(), TEXT("Position")));
+	Sig.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec2Def(), TEXT("Size")));
+	Sig.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Rotation")));
+	Sig.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Intensity")));
+	Sig.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Success")));
+#if WITH_EDITORONLY_DATA
+	Sig.Description = LOCTEXT("AddStampDesc", "Add a stamp at world Position,it will be drawn on DrawingBoards in next frame. Rotation is yaw in degrees.");
+#endif
+	OutFunctions.Add(Sig);
+}
+
+void UNiagaraDataInterfaceInteractStamp::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo,
+                                                               void* InstanceData, FVMExternalFunction& OutFunc)
+{
+	if (BindingInfo.Name == AddStampName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceInteractStamp::VMAddStamp);
+	}
+}
+
+bool UNiagaraDataInterfaceInteractStamp::InitPerInstanceData(void* PerInstanceData,
+                                                             FNiagaraSystemInstance* SystemInstance)
+{
+	FNDIInteractStampInstanceData* InstanceData = new(PerInstanceData) FNDIInteractStampInstanceData();
+	if (const UWorld* World = SystemInstance->GetWorld())
+	{
+		InstanceData->Subsystem = World->GetSubsystem<UInteractiveWorldSubsystem>();
+	}
+	return true;
+}
+
+void UNiagaraDataInterfaceInteractStamp::DestroyPerInstanceData(void* PerInstanceData,
+                                                                FNiagaraSystemInstance* SystemInstance)
+{
+	FNDIInteractStampInstanceData* InstanceData = static_cast<FNDIInteractStampInstanceData*>(PerInstanceData);
+	InstanceData->~FNDIInteractStampInstanceData();
+}
+
+bool UNiagaraDataInterfaceInteractStamp::PerInstanceTickPostSimulate(void* PerInstanceData,
+                                                                     FNiagaraSystemInstance* SystemInstance,
+                                                                     float DeltaSeconds)
+{
+	FNDIInteractStampInstanceData* InstanceData = static_cast<FNDIInteractStampInstanceData*>(PerInstanceData);
+	TArray<FIWStamp> Stamps;
+	{
+		FScopeLock Lock(&InstanceData->StampsLock);
+		Swap(Stamps, InstanceData->Stamps);
+	}
+	UInteractiveWorldSubsystem* Subsystem = InstanceData->Subsystem.Get();
+	if (Subsystem && Stamps.Num() > 0)
+	{
+		Subsystem->SubmitStamps(StampMaterial, DrawingBoardClass, MoveTemp(Stamps));
+	}
+	//Never reset system instance
+	return false;
+}
+
+bool UNiagaraDataInterfaceInteractStamp::Equals(const UNiagaraDataInterface* Other) const
+{
+	if (!Super::Equals(Other))
+	{
+		return false;
+	}
+	const UNiagaraDataInterfaceInteractStamp* OtherTyped = CastChecked<const UNiagaraDataInterfaceInteractStamp>(Other);
+	return OtherTyped->StampMaterial == StampMaterial
+		&& OtherTyped->DrawingBoardClass == DrawingBoardClass
+		&& OtherTyped->MaxStampsPerFrame == MaxStampsPerFrame;
+}
+
+bool UNiagaraDataInterfaceInteractStamp::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination))
+	{
+		return false;
+	}
+	UNiagaraDataInterfaceInteractStamp* DestinationTyped = CastChecked<UNiagaraDataInterfaceInteractStamp>(Destination);
+	DestinationTyped->StampMaterial = StampMaterial;
+	DestinationTyped->DrawingBoardClass = DrawingBoardClass;
+	DestinationTyped->MaxStampsPerFrame = MaxStampsPerFrame;
+	return true;
+}
+
+void UNiagaraDataInterfaceInteractStamp::VMAddStamp(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<FNDIInteractStampInstanceData> InstanceData(Context);
+	FNDIInputParam<bool> InExecute(Context);
+	FNDIInputParam<FVector3f> InPosition(Context);
+	FNDIInputParam<FVector2f> InSize(Context);
+	FNDIInputParam<float> InRotation(Context);
+	FNDIInputParam<float> InIntensity(Context);
+	FNDIOutputParam<bool> OutSuccess(Context);
+	//VM runs on worker threads,stamps are counted as InteractiveWorld memory
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+
+	//Collect stamps of this chunk first,so we only lock once
+	TArray<FIWStamp, TInlineAllocator<64>> ChunkStamps;
+	TArray<int32, TInlineAllocator<64>> ChunkInstances;
+	for (int32 i = 0; i < Context.GetNumInstances(); ++i)
+	{
+		const bool bExecute = InExecute.GetAndAdvance();
+		const FVector3f Position = InPosition.GetAndAdvance();
+		const FVector2f Size = InSize.GetAndAdvance();
+		const float Rotation = InRotation.GetAndAdvance();
+		const float Intensity = InIntensity.GetAndAdvance();
+		if (bExecute)
+		{
+			FIWStamp& Stamp = ChunkStamps.AddDefaulted_GetRef();
+			Stamp.Location = FVector2D(Position.X, Position.Y);
+			Stamp.Size = FVector2D(Size.X, Size.Y);
+			Stamp.Rotation = Rotation;
+			Stamp.Intensity = Intensity;
+			ChunkInstances.Add(i);
+		}
+	}
+
+	int32 NumAccepted = ChunkStamps.Num();
+	if (NumAccepted > 0)
+	{
+		FScopeLock Lock(&InstanceData->StampsLock);
+		if (MaxStampsPerFrame >= 0)
+		{
+			NumAccepted = FMath::Clamp(MaxStampsPerFrame - InstanceData->Stamps.Num(), 0, NumAccepted);
+		}
+		InstanceData->Stamps.Append(ChunkStamps.GetData(), NumAccepted);
+	}
+
+	//Write results,particles over limit will fail
+	int32 NextExecuted = 0;
+	for (int32 i = 0; i < Context.GetNumInstances(); ++i)
+	{
+		bool bSuccess = false;
+		if (NextExecuted < ChunkInstances.Num() && ChunkInstances[NextExecuted] == i)
+		{
+			bSuccess = NextExecuted < NumAccepted;
+			NextExecuted++;
+		}
+		OutSuccess.SetAndAdvance(bSuccess);
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
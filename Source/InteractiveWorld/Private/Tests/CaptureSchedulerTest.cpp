@@ -0,0 +1,108 @@
+// Copyright 2023 Sun BoHeng
+
+#include "CaptureScheduler.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIWCaptureSchedulerTest, "InteractiveWorld.CaptureScheduler",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+static FIWCaptureRequest MakeCaptureRequest(int32 Id, const FVector2D& Center, float ViewDistance)
+{
+	FIWCaptureRequest Request;
+	Request.Id = Id;
+	Request.Bounds = FBox(FVector(Center.X - 10, Center.Y - 10, 0), FVector(Center.X + 10, Center.Y + 10, 100));
+	Request.ViewDistance = ViewDistance;
+	return Request;
+}
+
+static int32 CountScheduledRequests(const TArray<FIWCaptureJob>& Jobs)
+{
+	int32 Count = 0;
+	for (const auto& Job : Jobs)
+	{
+		Count += Job.RequestIndices.Num();
+	}
+	return Count;
+}
+
+bool FIWCaptureSchedulerTest::RunTest(const FString& Parameters)
+{
+	TArray<FIWCaptureJob> Jobs;
+
+	//Close requests merge into one square capture,requests over budget wait for next frame
+	{
+		FIWCaptureScheduler Scheduler;
+		Scheduler.MaxCapturesPerFrame = 2;
+		TArray<FIWCaptureRequest> Requests;
+		Requests.Add(MakeCaptureRequest(0, FVector2D(0, 0), 0));
+		Requests.Add(MakeCaptureRequest(1, FVector2D(40, 0), 0));
+		Requests.Add(MakeCaptureRequest(2, FVector2D(5000, 0), 100));
+		Requests.Add(MakeCaptureRequest(3, FVector2D(10000, 0), 200));
+
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Jobs limited by MaxCapturesPerFrame"), Jobs.Num(), 2);
+		TestEqual(TEXT("Close requests are merged"), CountScheduledRequests(Jobs), 3);
+		if (Jobs.Num() == 2)
+		{
+			TestEqual(TEXT("Nearest requests go first"), Jobs[0].RequestIndices.Num(), 2);
+			TestTrue(TEXT("Merged capture is square"), Jobs[0].Bounds.Min.Equals(FVector(-10, -30, 0)) && Jobs[0].Bounds.Max.Equals(FVector(50, 30, 100)));
+		}
+
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Only the waiting request is captured"), Jobs.Num(), 1);
+		if (Jobs.Num() == 1)
+		{
+			TestTrue(TEXT("Waiting request is captured next frame"), Jobs[0].RequestIndices.Num() == 1 && Jobs[0].RequestIndices[0] == 3);
+		}
+
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Still requests are not captured again"), Jobs.Num(), 0);
+
+		Scheduler.Remove(0);
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Removed request is captured as new"), CountScheduledRequests(Jobs), 1);
+	}
+
+	//Merged capture can't grow over MaxCaptureSize
+	{
+		FIWCaptureScheduler Scheduler;
+		Scheduler.MaxCaptureSize = 50;
+		TArray<FIWCaptureRequest> Requests;
+		Requests.Add(MakeCaptureRequest(0, FVector2D(0, 0), 0));
+		Requests.Add(MakeCaptureRequest(1, FVector2D(40, 0), 0));
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Too large merge is split"), Jobs.Num(), 2);
+	}
+
+	//Far moving requests wait for their interval
+	{
+		FIWCaptureScheduler Scheduler;
+		Scheduler.IntervalDistance = 2000;
+		TArray<FIWCaptureRequest> Requests;
+		Requests.Add(MakeCaptureRequest(0, FVector2D(0, 0), 4500));
+		TestEqual(TEXT("Interval by distance"), Scheduler.GetUpdateInterval(4500), 2);
+		Scheduler.Schedule(Requests, Jobs);
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("New far request waits for its interval"), Jobs.Num(), 0);
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("New far request is captured after interval"), Jobs.Num(), 1);
+
+		Requests[0] = MakeCaptureRequest(0, FVector2D(100, 0), 4500);
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("First frame of interval waits"), Jobs.Num(), 0);
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Second frame of interval waits"), Jobs.Num(), 0);
+		Scheduler.Schedule(Requests, Jobs);
+		TestEqual(TEXT("Moved request is captured after interval"), Jobs.Num(), 1);
+
+		Scheduler.MaxInterval = 1;
+		TestEqual(TEXT("Interval clamped by MaxInterval"), Scheduler.GetUpdateInterval(100000), 1);
+		Scheduler.IntervalDistance = 0;
+		TestEqual(TEXT("No interval without IntervalDistance"), Scheduler.GetUpdateInterval(100000), 0);
+	}
+	return true;
+}
+
+#endif
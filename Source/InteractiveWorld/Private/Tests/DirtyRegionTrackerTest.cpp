@@ -0,0 +1,83 @@
+// Copyright 2023 Sun BoHeng
+
+#include "DirtyRegionTracker.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIWDirtyRegionTrackerTest, "InteractiveWorld.DirtyRegionTracker",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FIWDirtyRegionTrackerTest::RunTest(const FString& Parameters)
+{
+	const FBox2D Bounds(FVector2D(0, 0), FVector2D(256, 256));
+	TArray<FBox2D> Rects;
+
+	//Overlapping rects grow one region,separate ones add regions
+	{
+		FIWDirtyRegionTracker Tracker;
+		Tracker.AddRect(FBox2D(FVector2D(10, 10), FVector2D(20, 20)));
+		Tracker.AddRect(FBox2D(FVector2D(15, 15), FVector2D(30, 30)));
+		TestEqual(TEXT("Overlapping rects merge"), Tracker.Num(), 1);
+		const FBox2D DirtyBounds = Tracker.GetDirtyBounds(Bounds);
+		TestTrue(TEXT("Merged bounds"), DirtyBounds.bIsValid && DirtyBounds.Min.Equals(FVector2D(10, 10)) && DirtyBounds.Max.Equals(FVector2D(30, 30)));
+		Tracker.AddRect(FBox2D(FVector2D(100, 100), FVector2D(110, 110)));
+		TestEqual(TEXT("Separate rect adds a region"), Tracker.Num(), 2);
+		Tracker.AddRect(FBox2D(ForceInit));
+		TestEqual(TEXT("Invalid rect is ignored"), Tracker.Num(), 2);
+	}
+
+	//More than MaxRects merges the pair that grows least
+	{
+		FIWDirtyRegionTracker Tracker;
+		Tracker.MaxRects = 2;
+		Tracker.AddRect(FBox2D(FVector2D(0, 0), FVector2D(10, 10)));
+		Tracker.AddRect(FBox2D(FVector2D(12, 0), FVector2D(22, 10)));
+		Tracker.AddRect(FBox2D(FVector2D(200, 200), FVector2D(210, 210)));
+		TestEqual(TEXT("Regions limited by MaxRects"), Tracker.Num(), 2);
+		Tracker.GetDirtyRects(Bounds, Rects);
+		bool bNearPairMerged = false;
+		for (const auto& Rect : Rects)
+		{
+			bNearPairMerged |= Rect.Min.Equals(FVector2D(0, 0)) && Rect.Max.Equals(FVector2D(22, 10));
+		}
+		TestTrue(TEXT("Nearest regions are merged"), bNearPairMerged);
+	}
+
+	//Regions settle after SettleFrames,drawing again keeps them dirty
+	{
+		FIWDirtyRegionTracker Tracker;
+		Tracker.SettleFrames = 2;
+		Tracker.AddRect(FBox2D(FVector2D(0, 0), FVector2D(10, 10)));
+		Tracker.EndFrame();
+		Tracker.EndFrame();
+		TestTrue(TEXT("Settling region stays dirty"), Tracker.IsDirty());
+		Tracker.AddRect(FBox2D(FVector2D(5, 5), FVector2D(8, 8)));
+		Tracker.EndFrame();
+		Tracker.EndFrame();
+		TestTrue(TEXT("Drawing again resets age"), Tracker.IsDirty());
+		Tracker.EndFrame();
+		TestFalse(TEXT("Settled region is dropped"), Tracker.IsDirty());
+	}
+
+	//Padding,shifting and clamping to bounds
+	{
+		FIWDirtyRegionTracker Tracker;
+		Tracker.Padding = 4;
+		Tracker.AddRect(FBox2D(FVector2D(10, 10), FVector2D(20, 20)));
+		Tracker.Shift(FVector2D(-20, 5));
+		Tracker.GetDirtyRects(Bounds, Rects);
+		TestEqual(TEXT("One clamped rect"), Rects.Num(), 1);
+		if (Rects.Num() == 1)
+		{
+			TestTrue(TEXT("Padded,shifted and clamped"), Rects[0].Min.Equals(FVector2D(0, 11)) && Rects[0].Max.Equals(FVector2D(4, 29)));
+		}
+		Tracker.Shift(FVector2D(-100, 0));
+		TestFalse(TEXT("Outside bounds gives invalid bounds"), Tracker.GetDirtyBounds(Bounds).bIsValid);
+		Tracker.Reset();
+		TestFalse(TEXT("Reset clears regions"), Tracker.IsDirty());
+	}
+	return true;
+}
+
+#endif
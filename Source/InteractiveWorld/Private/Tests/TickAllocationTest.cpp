@@ -0,0 +1,135 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractiveWorldSubsystem.h"
+#include "InteractBrush.h"
+#include "WorldDrawingBoard.h"
+#include "Engine/Engine.h"
+#include "Materials/Material.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIWTickAllocationTest, "InteractiveWorld.TickAllocations",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+//Forwards everything to the real allocator and counts allocations made on game thread
+class FIWAllocationCounter final : public FMalloc
+{
+public:
+	explicit FIWAllocationCounter(FMalloc* InInnerMalloc) : InnerMalloc(InInnerMalloc)
+	{
+	}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count > 0)
+		{
+			CountAllocation();
+		}
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("IWAllocationCounter");
+	}
+
+	int32 NumAllocations = 0;
+
+private:
+	FMalloc* InnerMalloc;
+
+	void CountAllocation()
+	{
+		if (IsInGameThread())
+		{
+			NumAllocations++;
+		}
+	}
+};
+
+bool FIWTickAllocationTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+	UInteractiveWorldSubsystem* Subsystem = World->GetSubsystem<UInteractiveWorldSubsystem>();
+
+	//Active DrawingBoard without RT Draw On,so stamps are allocated,instances built and simulation steps run,
+	//but instances are dropped instead of drawn.Canvas drawing allocates inside engine,it is not what this test looks at
+	AWorldDrawingBoard* DrawingBoard = World->SpawnActor<AWorldDrawingBoard>();
+	for (int32 i = 0; i < 8; i++)
+	{
+		AActor* Owner = World->SpawnActor<AActor>();
+		UInteractBrush* Brush = NewObject<UInteractBrush>(Owner);
+		Brush->bDrawEveryFrame = true;
+		Owner->SetRootComponent(Brush);
+		Brush->RegisterComponent();
+	}
+	UMaterialInterface* Material = UMaterial::GetDefaultMaterial(MD_Surface);
+
+	constexpr float DeltaTime = 1.f / 60.f;
+	auto TickWithStamps = [Subsystem, Material]()
+	{
+		for (int32 i = 0; i < 16; i++)
+		{
+			FIWStamp Stamp;
+			Stamp.Location = FVector2D(i * 100.f, 0);
+			Subsystem->SubmitStamp(Material, nullptr, Stamp);
+		}
+		Subsystem->Tick(DeltaTime);
+	};
+
+	//Warm up,brushes activate and buffers grow to their steady size
+	for (int32 Frame = 0; Frame < 8; Frame++)
+	{
+		TickWithStamps();
+	}
+	TestEqual(TEXT("Brushes are registered"), Subsystem->GetRegisteredInteractBrushes().Num(), 8);
+	TestTrue(TEXT("DrawingBoard is active"), DrawingBoard->GetActiveState());
+	TestNull(TEXT("DrawingBoard has nothing to draw on"), DrawingBoard->GetRTDrawOn());
+
+	FIWAllocationCounter AllocationCounter(GMalloc);
+	FMalloc* RealMalloc = GMalloc;
+	GMalloc = &AllocationCounter;
+	for (int32 Frame = 0; Frame < 4; Frame++)
+	{
+		TickWithStamps();
+	}
+	GMalloc = RealMalloc;
+	TestEqual(TEXT("Warmed ticks don't allocate"), AllocationCounter.NumAllocations, 0);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,86 @@
+// Copyright 2023 Sun BoHeng
+
+#include "WindFieldSolver.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIWWindFieldSolverTest, "InteractiveWorld.WindFieldSolver",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+//Power of two time step,so frame times add up exactly
+static constexpr float WindTestTimeStep = 1.f / 32.f;
+
+static void InitializeTestSolver(FIWWindFieldSolver& Solver)
+{
+	Solver.TimeStep = WindTestTimeStep;
+	Solver.Initialize(16, 100);
+	Solver.SetCenter(FVector2D::ZeroVector);
+}
+
+//A brush pushing wind every frame for one second at FramesPerStep frames per solver step
+static void RunTestBrush(FIWWindFieldSolver& Solver, int32 FramesPerStep)
+{
+	const int32 NumFrames = 32 * FramesPerStep;
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		Solver.AddForce(FVector2D::ZeroVector, FVector2D(300, 0), 300);
+		Solver.Update(WindTestTimeStep / FramesPerStep);
+	}
+}
+
+bool FIWWindFieldSolverTest::RunTest(const FString& Parameters)
+{
+	const FVector2D SampleLocations[] = {FVector2D(0, 0), FVector2D(150, 50), FVector2D(-250, 120), FVector2D(400, -300)};
+
+	//Forces are not stacked by frames without a step,so wind doesn't depend on frame rate
+	{
+		FIWWindFieldSolver StepPerFrame;
+		FIWWindFieldSolver TwoFramesPerStep;
+		FIWWindFieldSolver FourFramesPerStep;
+		InitializeTestSolver(StepPerFrame);
+		InitializeTestSolver(TwoFramesPerStep);
+		InitializeTestSolver(FourFramesPerStep);
+		RunTestBrush(StepPerFrame, 1);
+		RunTestBrush(TwoFramesPerStep, 2);
+		RunTestBrush(FourFramesPerStep, 4);
+		TestTrue(TEXT("Brush pushes wind"), StepPerFrame.SampleVelocity(FVector2D::ZeroVector).X > 1);
+		for (const FVector2D& Location : SampleLocations)
+		{
+			const FVector2D Expected = StepPerFrame.SampleVelocity(Location);
+			TestTrue(FString::Printf(TEXT("Same wind at %s with two frames per step"), *Location.ToString()),
+			         TwoFramesPerStep.SampleVelocity(Location).Equals(Expected, 0.01f));
+			TestTrue(FString::Printf(TEXT("Same wind at %s with four frames per step"), *Location.ToString()),
+			         FourFramesPerStep.SampleVelocity(Location).Equals(Expected, 0.01f));
+		}
+
+		//Wind stays in world when grid follows center
+		FVector2D Before[UE_ARRAY_COUNT(SampleLocations)];
+		for (int32 i = 0; i < UE_ARRAY_COUNT(SampleLocations); i++)
+		{
+			Before[i] = StepPerFrame.SampleVelocity(SampleLocations[i]);
+		}
+		StepPerFrame.SetCenter(FVector2D(300, 0));
+		for (int32 i = 0; i < UE_ARRAY_COUNT(SampleLocations); i++)
+		{
+			TestTrue(FString::Printf(TEXT("Wind at %s kept after moving grid"), *SampleLocations[i].ToString()),
+			         StepPerFrame.SampleVelocity(SampleLocations[i]).Equals(Before[i], 0.001f));
+		}
+		TestTrue(TEXT("No wind outside grid"), StepPerFrame.SampleVelocity(FVector2D(100000, 0)).IsZero());
+	}
+
+	//Time over MaxStepsPerUpdate is caught up in next Updates,the rest is counted as dropped
+	{
+		FIWWindFieldSolver Solver;
+		InitializeTestSolver(Solver);
+		Solver.MaxStepsPerUpdate = 2;
+		TestEqual(TEXT("Steps limited by MaxStepsPerUpdate"), Solver.Update(10 * WindTestTimeStep), 2);
+		TestEqual(TEXT("Time over backlog is dropped"), Solver.GetDroppedTime(), 6 * WindTestTimeStep);
+		TestEqual(TEXT("Backlog is caught up"), Solver.Update(0), 2);
+		TestEqual(TEXT("Nothing left after catching up"), Solver.Update(0), 0);
+		TestTrue(TEXT("No force,no wind"), Solver.SampleVelocity(FVector2D::ZeroVector).IsZero());
+	}
+	return true;
+}
+
+#endif
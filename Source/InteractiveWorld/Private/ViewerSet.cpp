@@ -0,0 +1,101 @@
+// Copyright 2023 Sun BoHeng
+
+#include "ViewerSet.h"
+
+//Few viewers are faster to test one by one than through cells
+static constexpr int32 MaxLinearViewers = 8;
+//Larger queries visit too many cells,test viewers one by one instead
+static constexpr int32 MaxQueryCells = 64;
+
+void FIWViewerSet::Reset(float InCullDistance)
+{
+	CullDistance = FMath::Max(InCullDistance, 0.f);
+	//Query range is at least CullDistance,so most queries cover 2x2 cells
+	CellSize = FMath::Max(CullDistance, 100.f);
+	Viewers.Reset();
+	Cells.Reset();
+	bUseCells = false;
+}
+
+void FIWViewerSet::AddViewer(const FVector& Location)
+{
+	//Split screen players often share a view target
+	if (Viewers.Num() > 0 && Viewers.Last().Equals(Location))
+	{
+		return;
+	}
+	Viewers.Add(Location);
+}
+
+void FIWViewerSet::Build()
+{
+	bUseCells = Viewers.Num() > MaxLinearViewers;
+	if (!bUseCells)
+	{
+		return;
+	}
+	for (int32 i = 0; i < Viewers.Num(); i++)
+	{
+		Cells.FindOrAdd(GetCell(Viewers[i].X, Viewers[i].Y)).Add(i);
+	}
+}
+
+FIntPoint FIWViewerSet::GetCell(double X, double Y) const
+{
+	return FIntPoint(FMath::FloorToInt(X / CellSize), FMath::FloorToInt(Y / CellSize));
+}
+
+bool FIWViewerSet::IsInRange(const FVector& Location, float Radius) const
+{
+	const double Range = CullDistance + Radius;
+	const double RangeSquared = Range * Range;
+	auto IsViewerInRange = [&](int32 Index)
+	{
+		return FVector::DistSquaredXY(Viewers[Index], Location) <= RangeSquared;
+	};
+
+	if (bUseCells)
+	{
+		const FIntPoint MinCell = GetCell(Location.X - Range, Location.Y - Range);
+		const FIntPoint MaxCell = GetCell(Location.X + Range, Location.Y + Range);
+		const FIntPoint NumCells = MaxCell - MinCell + FIntPoint(1, 1);
+		if (NumCells.X * NumCells.Y <= MaxQueryCells)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+				{
+					if (const auto* Cell = Cells.Find(FIntPoint(X, Y)))
+					{
+						for (const int32 Index : *Cell)
+						{
+							if (IsViewerInRange(Index))
+							{
+								return true;
+							}
+						}
+					}
+				}
+			}
+			return false;
+		}
+	}
+	for (int32 i = 0; i < Viewers.Num(); i++)
+	{
+		if (IsViewerInRange(i))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+float FIWViewerSet::GetNearestDistance(const FVector& Location) const
+{
+	double NearestSquared = TNumericLimits<double>::Max();
+	for (const auto& Viewer : Viewers)
+	{
+		NearestSquared = FMath::Min(NearestSquared, FVector::DistSquaredXY(Viewer, Location));
+	}
+	return Viewers.Num() > 0 ? static_cast<float>(FMath::Sqrt(NearestSquared)) : TNumericLimits<float>::Max();
+}
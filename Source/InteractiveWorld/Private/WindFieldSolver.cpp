@@ -0,0 +1,306 @@
+// Copyright 2023 Sun BoHeng
+
+#include "WindFieldSolver.h"
+
+#include "Async/ParallelFor.h"
+
+//Small grids are faster on one thread
+static constexpr int32 MinParallelGridSize = 64;
+
+void FIWWindFieldSolver::Initialize(int32 InGridSize, float InCellSize)
+{
+	GridSize = FMath::Max(InGridSize, 4);
+	CellSize = FMath::Max(InCellSize, 1.f);
+	const int32 NumCells = GridSize * GridSize;
+	VelocityX.SetNumZeroed(NumCells);
+	VelocityY.SetNumZeroed(NumCells);
+	Pressure.SetNumZeroed(NumCells);
+	Divergence.SetNumZeroed(NumCells);
+	TempX.SetNumZeroed(NumCells);
+	TempY.SetNumZeroed(NumCells);
+	ForceX.SetNumZeroed(NumCells);
+	ForceY.SetNumZeroed(NumCells);
+	ForceWeightSum.SetNumZeroed(NumCells);
+	ForceWeight.SetNumZeroed(NumCells);
+	bHasForces = false;
+	TimeAccumulator = 0;
+	DroppedTime = 0;
+}
+
+SIZE_T FIWWindFieldSolver::GetAllocatedSize() const
+{
+	return VelocityX.GetAllocatedSize() + VelocityY.GetAllocatedSize() + Pressure.GetAllocatedSize()
+		+ Divergence.GetAllocatedSize() + TempX.GetAllocatedSize() + TempY.GetAllocatedSize() + ForceX.GetAllocatedSize()
+		+ ForceY.GetAllocatedSize() + ForceWeightSum.GetAllocatedSize() + ForceWeight.GetAllocatedSize();
+}
+
+void FIWWindFieldSolver::SetCenter(const FVector2D& WorldCenter)
+{
+	if (!IsInitialized())
+	{
+		return;
+	}
+	const FIntPoint NewOriginCell(FMath::FloorToInt(WorldCenter.X / CellSize) - GridSize / 2,
+	                              FMath::FloorToInt(WorldCenter.Y / CellSize) - GridSize / 2);
+	if (NewOriginCell != OriginCell)
+	{
+		Shift(NewOriginCell - OriginCell);
+		OriginCell = NewOriginCell;
+	}
+}
+
+void FIWWindFieldSolver::Shift(const FIntPoint& Offset)
+{
+	//Cell (X,Y) of new grid was cell (X+Offset) of old grid
+	auto ShiftField = [this, &Offset](TArray<float>& Field)
+	{
+		TempX.SetNumUninitialized(Field.Num());
+		for (int32 Y = 0; Y < GridSize; Y++)
+		{
+			const int32 OldY = Y + Offset.Y;
+			for (int32 X = 0; X < GridSize; X++)
+			{
+				const int32 OldX = X + Offset.X;
+				const bool bInside = OldX >= 0 && OldX < GridSize && OldY >= 0 && OldY < GridSize;
+				TempX[GetIndex(X, Y)] = bInside ? Field[GetIndex(OldX, OldY)] : 0.f;
+			}
+		}
+		Swap(Field, TempX);
+	};
+	ShiftField(VelocityX);
+	ShiftField(VelocityY);
+	ShiftField(Pressure);
+	if (bHasForces)
+	{
+		//Forces are in world too
+		ShiftField(ForceX);
+		ShiftField(ForceY);
+		ShiftField(ForceWeightSum);
+		ShiftField(ForceWeight);
+	}
+}
+
+void FIWWindFieldSolver::AddForce(const FVector2D& Location, const FVector2D& Velocity, float Radius)
+{
+	if (!IsInitialized())
+	{
+		return;
+	}
+	const FVector2D GridCenter = (Location - GetOrigin()) / CellSize - 0.5f;
+	const float GridRadius = FMath::Max(Radius, 1.f) / CellSize;
+	const int32 MinX = FMath::Max(FMath::FloorToInt(GridCenter.X - GridRadius), 0);
+	const int32 MaxX = FMath::Min(FMath::CeilToInt(GridCenter.X + GridRadius), GridSize - 1);
+	const int32 MinY = FMath::Max(FMath::FloorToInt(GridCenter.Y - GridRadius), 0);
+	const int32 MaxY = FMath::Min(FMath::CeilToInt(GridCenter.Y + GridRadius), GridSize - 1);
+	for (int32 Y = MinY; Y <= MaxY; Y++)
+	{
+		for (int32 X = MinX; X <= MaxX; X++)
+		{
+			const float Weight = 1.f - FVector2D::Distance(FVector2D(X, Y), GridCenter) / GridRadius;
+			if (Weight <= 0)
+			{
+				continue;
+			}
+			//The same brush adding its force again before a step pulls toward the same velocity,not twice as hard
+			const int32 Index = GetIndex(X, Y);
+			ForceX[Index] += Velocity.X * Weight;
+			ForceY[Index] += Velocity.Y * Weight;
+			ForceWeightSum[Index] += Weight;
+			ForceWeight[Index] = FMath::Max(ForceWeight[Index], Weight);
+			bHasForces = true;
+		}
+	}
+}
+
+void FIWWindFieldSolver::ClearForces()
+{
+	if (!bHasForces)
+	{
+		return;
+	}
+	FMemory::Memzero(ForceX.GetData(), ForceX.Num() * sizeof(float));
+	FMemory::Memzero(ForceY.GetData(), ForceY.Num() * sizeof(float));
+	FMemory::Memzero(ForceWeightSum.GetData(), ForceWeightSum.Num() * sizeof(float));
+	FMemory::Memzero(ForceWeight.GetData(), ForceWeight.Num() * sizeof(float));
+	bHasForces = false;
+}
+
+int32 FIWWindFieldSolver::Update(float DeltaTime)
+{
+	if (!IsInitialized() || TimeStep <= 0)
+	{
+		return 0;
+	}
+	TimeAccumulator += DeltaTime;
+	int32 Steps = 0;
+	while (TimeAccumulator >= TimeStep && Steps < MaxStepsPerUpdate)
+	{
+		Step();
+		TimeAccumulator -= TimeStep;
+		Steps++;
+	}
+	//Forces of frames without a step are kept and merged,so they are applied in the same steps at any frame rate
+	if (Steps > 0)
+	{
+		ClearForces();
+	}
+	//Too slow to catch up,keep a budget of steps for next Updates and count the rest as dropped
+	const float MaxBacklog = FMath::Max(MaxStepsPerUpdate, 1) * TimeStep;
+	if (TimeAccumulator > MaxBacklog)
+	{
+		DroppedTime += TimeAccumulator - MaxBacklog;
+		TimeAccumulator = MaxBacklog;
+	}
+	return Steps;
+}
+
+void FIWWindFieldSolver::Step()
+{
+	if (!IsInitialized())
+	{
+		return;
+	}
+	ApplyForces();
+	Advect(TimeStep);
+	Project();
+}
+
+void FIWWindFieldSolver::ApplyForces()
+{
+	if (!bHasForces)
+	{
+		return;
+	}
+	//Each cell is pulled once per step toward weighted average of its forces
+	for (int32 Index = 0; Index < ForceWeight.Num(); Index++)
+	{
+		const float Weight = ForceWeight[Index];
+		if (Weight <= 0)
+		{
+			continue;
+		}
+		VelocityX[Index] = FMath::Lerp(VelocityX[Index], ForceX[Index] / ForceWeightSum[Index], Weight);
+		VelocityY[Index] = FMath::Lerp(VelocityY[Index], ForceY[Index] / ForceWeightSum[Index], Weight);
+	}
+}
+
+float FIWWindFieldSolver::SampleField(const TArray<float>& Field, float GridX, float GridY) const
+{
+	GridX = FMath::Clamp(GridX, 0.f, static_cast<float>(GridSize - 1));
+	GridY = FMath::Clamp(GridY, 0.f, static_cast<float>(GridSize - 1));
+	const int32 X0 = FMath::Min(FMath::FloorToInt(GridX), GridSize - 2);
+	const int32 Y0 = FMath::Min(FMath::FloorToInt(GridY), GridSize - 2);
+	const float AlphaX = GridX - X0;
+	const float AlphaY = GridY - Y0;
+	const float Top = FMath::Lerp(Field[GetIndex(X0, Y0)], Field[GetIndex(X0 + 1, Y0)], AlphaX);
+	const float Bottom = FMath::Lerp(Field[GetIndex(X0, Y0 + 1)], Field[GetIndex(X0 + 1, Y0 + 1)], AlphaX);
+	return FMath::Lerp(Top, Bottom, AlphaY);
+}
+
+void FIWWindFieldSolver::Advect(float DeltaTime)
+{
+	//Semi-Lagrangian,trace back along velocity and read old field
+	const float GridStep = DeltaTime / CellSize;
+	const float Damping = FMath::Max(1.f - Dissipation * DeltaTime, 0.f);
+	ParallelFor(GridSize, [this, GridStep, Damping](int32 Y)
+	{
+		for (int32 X = 0; X < GridSize; X++)
+		{
+			const int32 Index = GetIndex(X, Y);
+			const float FromX = X - VelocityX[Index] * GridStep;
+			const float FromY = Y - VelocityY[Index] * GridStep;
+			TempX[Index] = SampleField(VelocityX, FromX, FromY) * Damping;
+			TempY[Index] = SampleField(VelocityY, FromX, FromY) * Damping;
+		}
+	}, GridSize < MinParallelGridSize);
+	Swap(VelocityX, TempX);
+	Swap(VelocityY, TempY);
+}
+
+void FIWWindFieldSolver::Project()
+{
+	//Edges use their own value for missing neighbours
+	const int32 Last = GridSize - 1;
+	ParallelFor(GridSize, [this, Last](int32 Y)
+	{
+		const int32 Up = FMath::Max(Y - 1, 0);
+		const int32 Down = FMath::Min(Y + 1, Last);
+		for (int32 X = 0; X < GridSize; X++)
+		{
+			const int32 Left = FMath::Max(X - 1, 0);
+			const int32 Right = FMath::Min(X + 1, Last);
+			Divergence[GetIndex(X, Y)] = -0.5f * (VelocityX[GetIndex(Right, Y)] - VelocityX[GetIndex(Left, Y)]
+				+ VelocityY[GetIndex(X, Down)] - VelocityY[GetIndex(X, Up)]);
+		}
+	}, GridSize < MinParallelGridSize);
+
+	//Jacobi reads last iteration only,so rows can run on any thread with the same result.
+	//Pressure of last step is the first guess
+	const VectorRegister4Float Quarter = VectorSetFloat1(0.25f);
+	for (int32 Iteration = 0; Iteration < PressureIterations; Iteration++)
+	{
+		ParallelFor(GridSize, [this, Last, &Quarter](int32 Y)
+		{
+			const float* Row = &Pressure[GetIndex(0, Y)];
+			const float* UpRow = &Pressure[GetIndex(0, FMath::Max(Y - 1, 0))];
+			const float* DownRow = &Pressure[GetIndex(0, FMath::Min(Y + 1, Last))];
+			const float* DivergenceRow = &Divergence[GetIndex(0, Y)];
+			float* OutRow = &TempX[GetIndex(0, Y)];
+
+			OutRow[0] = (UpRow[0] + DownRow[0] + Row[0] + Row[1] + DivergenceRow[0]) * 0.25f;
+			int32 X = 1;
+			for (; X + 4 <= Last; X += 4)
+			{
+				const VectorRegister4Float Vertical = VectorAdd(VectorLoad(UpRow + X), VectorLoad(DownRow + X));
+				const VectorRegister4Float Horizontal = VectorAdd(VectorLoad(Row + X - 1), VectorLoad(Row + X + 1));
+				const VectorRegister4Float Sum = VectorAdd(VectorAdd(Vertical, Horizontal), VectorLoad(DivergenceRow + X));
+				VectorStore(VectorMultiply(Sum, Quarter), OutRow + X);
+			}
+			for (; X < Last; X++)
+			{
+				OutRow[X] = (UpRow[X] + DownRow[X] + Row[X - 1] + Row[X + 1] + DivergenceRow[X]) * 0.25f;
+			}
+			OutRow[Last] = (UpRow[Last] + DownRow[Last] + Row[Last - 1] + Row[Last] + DivergenceRow[Last]) * 0.25f;
+		}, GridSize < MinParallelGridSize);
+		Swap(Pressure, TempX);
+	}
+
+	//Remove divergent part
+	ParallelFor(GridSize, [this, Last](int32 Y)
+	{
+		const int32 Up = FMath::Max(Y - 1, 0);
+		const int32 Down = FMath::Min(Y + 1, Last);
+		for (int32 X = 0; X < GridSize; X++)
+		{
+			const int32 Left = FMath::Max(X - 1, 0);
+			const int32 Right = FMath::Min(X + 1, Last);
+			const int32 Index = GetIndex(X, Y);
+			VelocityX[Index] -= 0.5f * (Pressure[GetIndex(Right, Y)] - Pressure[GetIndex(Left, Y)]);
+			VelocityY[Index] -= 0.5f * (Pressure[GetIndex(X, Down)] - Pressure[GetIndex(X, Up)]);
+		}
+	}, GridSize < MinParallelGridSize);
+}
+
+FVector2D FIWWindFieldSolver::SampleVelocity(const FVector2D& Location) const
+{
+	if (!IsInitialized())
+	{
+		return FVector2D::ZeroVector;
+	}
+	const FVector2D GridLocation = (Location - GetOrigin()) / CellSize - 0.5f;
+	if (GridLocation.X < -0.5f || GridLocation.Y < -0.5f || GridLocation.X > GridSize - 0.5f || GridLocation.Y > GridSize - 0.5f)
+	{
+		return FVector2D::ZeroVector;
+	}
+	return FVector2D(SampleField(VelocityX, GridLocation.X, GridLocation.Y),
+	                 SampleField(VelocityY, GridLocation.X, GridLocation.Y));
+}
+
+void FIWWindFieldSolver::SampleVelocities(TArrayView<const FVector2D> Locations, TArrayView<FVector2D> OutVelocities) const
+{
+	check(Locations.Num() == OutVelocities.Num());
+	for (int32 i = 0; i < Locations.Num(); i++)
+	{
+		OutVelocities[i] = SampleVelocity(Locations[i]);
+	}
+}
@@ -0,0 +1,214 @@
+// Copyright 2023 Sun BoHeng
+
+#include "WorldClipmapDrawingBoard.h"
+
+#include "CanvasItem.h"
+#include "Runtime/Engine/Classes/Engine/Canvas.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Kismet/KismetRenderingLibrary.h"
+
+AWorldClipmapDrawingBoard::AWorldClipmapDrawingBoard()
+{
+}
+
+void AWorldClipmapDrawingBoard::BeginPlay()
+{
+	//Quads are transformed from level 0 to other levels,which doesn't work with wrapped addressing
+	if (bWrapAroundCanvas)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: Wrap around canvas is not supported by clipmap DrawingBoards,it is turned off"), *GetName());
+		bWrapAroundCanvas = false;
+	}
+	Super::BeginPlay();
+	//Levels can be sampled before the first draw
+	UpdateLevelRenderTargets(RTBrushDrawOn);
+}
+
+void AWorldClipmapDrawingBoard::UpdateLevelRenderTargets(UTextureRenderTarget2D* RTDrawOn)
+{
+	if (!RTDrawOn)
+	{
+		return;
+	}
+	LevelRenderTargets.SetNum(NumLevels);
+	LevelShiftRemainders.SetNumZeroed(NumLevels);
+	LevelRenderTargets[0] = RTDrawOn;
+	for (int32 Level = 1; Level < NumLevels; Level++)
+	{
+		if (!LevelRenderTargets[Level])
+		{
+			LevelRenderTargets[Level] = UKismetRenderingLibrary::CreateRenderTarget2D(
+				this, RTDrawOn->SizeX, RTDrawOn->SizeY, RTDrawOn->RenderTargetFormat, RTDrawOn->ClearColor);
+		}
+	}
+}
+
+void AWorldClipmapDrawingBoard::OnRenderTargetsAcquired_Implementation()
+{
+	Super::OnRenderTargetsAcquired_Implementation();
+	UpdateLevelRenderTargets(RTBrushDrawOn);
+}
+
+void AWorldClipmapDrawingBoard::OnCanvasMoved()
+{
+	UpdateLevelRenderTargets(RTBrushDrawOn);
+	//Content can't be kept when canvas is rotated or resized
+	const bool bKeepContent = CanvasWorldYaw == PreviousCanvasWorldYaw && CanvasWorldSize == PreviousCanvasWorldSize;
+	const FVector2D CanvasOffset = UKismetMathLibrary::GetRotated2D(PreviousCanvasWorldLocation - CanvasWorldLocation,
+	                                                                CanvasWorldYaw * -1);
+	for (int32 Level = 1; Level < LevelRenderTargets.Num(); Level++)
+	{
+		UTextureRenderTarget2D* LevelRT = LevelRenderTargets[Level];
+		if (!LevelRT)
+		{
+			continue;
+		}
+		if (!bKeepContent)
+		{
+			LevelShiftRemainders[Level] = FVector2D::ZeroVector;
+			UKismetRenderingLibrary::ClearRenderTarget2D(this, LevelRT, LevelRT->ClearColor);
+			continue;
+		}
+		const double LevelScale = static_cast<double>(1 << Level);
+		const FVector2D PixelOffset = CanvasOffset / (CanvasWorldSize * LevelScale) * FVector2D(LevelRT->SizeX, LevelRT->SizeY)
+			+ LevelShiftRemainders[Level];
+		const FVector2D WholePixelOffset(FMath::RoundToDouble(PixelOffset.X), FMath::RoundToDouble(PixelOffset.Y));
+		LevelShiftRemainders[Level] = PixelOffset - WholePixelOffset;
+		ShiftRenderTargetContent(LevelRT, WholePixelOffset, LevelShiftRT);
+	}
+}
+
+void AWorldClipmapDrawingBoard::DrawBrushes(const TArray<UInteractBrush*>& Brushes, UTextureRenderTarget2D* RTDrawOn)
+{
+	//RTDrawOn may be replaced by pool or rings
+	UpdateLevelRenderTargets(RTDrawOn);
+
+	//Brushes draw once,in level 0 canvas space
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, RTDrawOn, CanvasDrawOn, CanvasSize, DrawContext);
+	DrawBrushesOnCanvas(Brushes, CanvasDrawOn, CanvasSize);
+	//Keep instances of level 0 for other levels,they are reset after all levels are drawn
+	DrawPendingInstances(CanvasDrawOn);
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+
+	for (int32 Level = 1; Level < NumLevels; Level++)
+	{
+		DrawInstancesOnLevel(TriangleInstancesMap, Level);
+	}
+	ResetPendingInstances();
+}
+
+void AWorldClipmapDrawingBoard::DrawInstancesOnLevel(const TMap<UMaterialInterface*, FIWTriangleList>& Instances,
+                                                     int32 Level)
+{
+	UTextureRenderTarget2D* LevelRT = GetLevelRenderTarget(Level);
+	if (!LevelRT)
+	{
+		return;
+	}
+	const double LevelScale = static_cast<double>(1 << Level);
+	const FVector2D Center = RTSize / 2;
+	const FVector2D LevelRTScale = FVector2D(LevelRT->SizeX, LevelRT->SizeY) / RTSize;
+	auto ToLevel = [&](const FVector2D& Position)-> FVector2D
+	{
+		return (Center + (Position - Center) / LevelScale) * LevelRTScale;
+	};
+
+	UCanvas* CanvasDrawOn = nullptr;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	for (const auto& Elem : Instances)
+	{
+		if (!Elem.Key)
+		{
+			continue;
+		}
+		LevelTriangles.Reset();
+		for (const auto& Triangle : Elem.Value.Triangles)
+		{
+			//Smaller than one pixel in this level,skip it
+			const FVector2D Positions[3] = {Triangle.V0_Pos, Triangle.V1_Pos, Triangle.V2_Pos};
+			const FVector2D TriangleSize = FBox2D(Positions, 3).GetSize() / LevelScale;
+			if (FMath::Max(TriangleSize.X, TriangleSize.Y) < 1)
+			{
+				continue;
+			}
+			FCanvasUVTri& LevelTriangle = LevelTriangles.Add_GetRef(Triangle);
+			LevelTriangle.V0_Pos = ToLevel(Triangle.V0_Pos);
+			LevelTriangle.V1_Pos = ToLevel(Triangle.V1_Pos);
+			LevelTriangle.V2_Pos = ToLevel(Triangle.V2_Pos);
+		}
+		if (LevelTriangles.Num() == 0)
+		{
+			continue;
+		}
+		if (!CanvasDrawOn)
+		{
+			UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, LevelRT, CanvasDrawOn, CanvasSize, DrawContext);
+		}
+		FCanvasTriangleItem TriangleItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, NULL);
+		TriangleItem.MaterialRenderProxy = Elem.Key->GetRenderProxy();
+		Swap(TriangleItem.TriangleList, LevelTriangles);
+		CanvasDrawOn->DrawItem(TriangleItem);
+		Swap(TriangleItem.TriangleList, LevelTriangles);
+	}
+	if (CanvasDrawOn)
+	{
+		UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+	}
+}
+
+float AWorldClipmapDrawingBoard::GetNearestDistance(FVector2D WorldLocation) const
+{
+	const double CoarsestScale = static_cast<double>(1 << (NumLevels - 1));
+	FVector2D DistanceVector = UKismetMathLibrary::GetRotated2D(WorldLocation - CanvasWorldLocation,
+	                                                            CanvasWorldYaw * -1);
+	DistanceVector = FVector2D(FMath::Abs(DistanceVector.X), FMath::Abs(DistanceVector.Y)) - CanvasWorldSize * CoarsestScale;
+	return FVector2D(FMath::Max(DistanceVector.X, 0), FMath::Max(DistanceVector.Y, 0)).Length();
+}
+
+void AWorldClipmapDrawingBoard::GetRenderTargets(TArray<UTextureRenderTarget2D*>& OutRenderTargets) const
+{
+	Super::GetRenderTargets(OutRenderTargets);
+	for (const auto LevelRenderTarget : LevelRenderTargets)
+	{
+		if (LevelRenderTarget)
+		{
+			OutRenderTargets.AddUnique(LevelRenderTarget);
+		}
+	}
+	if (LevelShiftRT)
+	{
+		OutRenderTargets.AddUnique(LevelShiftRT);
+	}
+}
+
+void AWorldClipmapDrawingBoard::GetLevelParameters(int32 Level, FVector2D& OutCanvasWorldSize,
+                                                   FVector2D& OutPixelWorldSize) const
+{
+	const double LevelScale = static_cast<double>(1 << FMath::Clamp(Level, 0, NumLevels - 1));
+	OutCanvasWorldSize = CanvasWorldSize * LevelScale;
+	OutPixelWorldSize = PixelWorldSize * LevelScale;
+}
+
+int32 AWorldClipmapDrawingBoard::GetFinestLevelAt(FVector2D WorldLocation, float Margin) const
+{
+	FVector2D LocalLocation = UKismetMathLibrary::GetRotated2D(WorldLocation - CanvasWorldLocation,
+	                                                           CanvasWorldYaw * -1);
+	LocalLocation = FVector2D(FMath::Abs(LocalLocation.X), FMath::Abs(LocalLocation.Y));
+	for (int32 Level = 0; Level < NumLevels; Level++)
+	{
+		FVector2D LevelCanvasWorldSize;
+		FVector2D LevelPixelWorldSize;
+		GetLevelParameters(Level, LevelCanvasWorldSize, LevelPixelWorldSize);
+		const FVector2D HalfExtent = LevelCanvasWorldSize / 2 - LevelPixelWorldSize * Margin;
+		if (LocalLocation.X <= HalfExtent.X && LocalLocation.Y <= HalfExtent.Y)
+		{
+			return Level;
+		}
+	}
+	return -1;
+}
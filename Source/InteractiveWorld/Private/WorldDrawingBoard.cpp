@@ -2,18 +2,65 @@
 
 #include "WorldDrawingBoard.h"
 
+#include "InteractiveWorld.h"
 #include "InteractiveWorldSubsystem.h"
+#include "InteractiveWorldBPLibrary.h"
+#include "InteractBakedLayer.h"
+#include "InteractStampMaterialData.h"
 #include "WorldInteractVolume.h"
+#include "EngineUtils.h"
+#include "Engine/AssetManager.h"
 #include "Runtime/Engine/Public/TimerManager.h"
 #include "Runtime/Engine/Classes/Engine/Canvas.h"
+#include "CanvasItem.h"
+#include "TextureResource.h"
+#include "Engine/Texture2D.h"
+#include "Misc/Compression.h"
+#include "RHIGPUReadback.h"
+#include "RenderingThread.h"
+#include "Async/Async.h"
+#include <atomic>
+#include "Materials/MaterialInstanceDynamic.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetRenderingLibrary.h"
+#if WITH_EDITOR
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#endif
 
 // Sets default values
 AWorldDrawingBoard::AWorldDrawingBoard()
 {
 }
 
+//Call Function with quad,in wrap around mode also with its copies on the other side of RT
+template<typename FunctionType>
+static void ForEachWrappedQuad(const FVector2D (&Vertices)[4], bool bWrapAround, const FVector2D& RTSize, FunctionType&& Function)
+{
+	if (!bWrapAround)
+	{
+		Function(Vertices);
+		return;
+	}
+
+	//Quad crossing RT edges should also be drawn on the other side
+	const FBox2D QuadBounds(Vertices, 4);
+	for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+	{
+		for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+		{
+			const FVector2D Offset = FVector2D(OffsetX, OffsetY) * RTSize;
+			const FBox2D ShiftedBounds = QuadBounds.ShiftBy(Offset);
+			if (ShiftedBounds.Max.X <= 0 || ShiftedBounds.Max.Y <= 0 || ShiftedBounds.Min.X >= RTSize.X || ShiftedBounds.Min.Y >= RTSize.Y)
+			{
+				continue;
+			}
+			const FVector2D ShiftedVertices[4] = {Vertices[0] + Offset, Vertices[1] + Offset, Vertices[2] + Offset, Vertices[3] + Offset};
+			Function(ShiftedVertices);
+		}
+	}
+}
+
 void AWorldDrawingBoard::UpdateActive()
 {
 	if ((!bUseInteractVolume || ActiveVolumes.Num() > 0) && bActive)
@@ -68,6 +115,14 @@ void AWorldDrawingBoard::BeginPlay()
 {
 	Super::BeginPlay();
 
+	//Wrapped addressing is anchored to world axes,a yawed canvas can't wrap
+	if (bWrapAroundCanvas && CanvasWorldYaw != 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: Canvas World Yaw is not supported with wrap around canvas,it is set to 0"), *GetName());
+		CanvasWorldYaw = 0;
+		PreviousCanvasWorldYaw = 0;
+	}
+
 	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->RegisterDrawingBoard(this);
 
 	UpdateActive();
@@ -78,6 +133,9 @@ void AWorldDrawingBoard::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 	ReBindInteractVolumes(false);
+	ReleasePooledRenderTargets(false);
+	//Released before and still saving
+	CancelContentSaves();
 	GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->UnregisterDrawingBoard(this);
 }
 
@@ -85,22 +143,32 @@ void AWorldDrawingBoard::UpdateDrawingBoardState_Implementation()
 {
 }
 
-void AWorldDrawingBoard::PrepareForSimulate(TArray<UInteractBrush*> Brushes)
+void AWorldDrawingBoard::PrepareForSimulate(const TArray<UInteractBrush*>& Brushes)
 {
-	if (Brushes.Num() > 0)
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	if (Brushes.Num() > 0 || HasPendingInstances())
 	{
 		//Brush will draw on this frame,so TimeFromLastDraw = 0
 		TimeFromLastDraw = 0;
 		
-		PreSimulate();
-		if (RTBrushDrawOn)
+		PublishAnalyticTime();
+		PublishCanvasParameters();
+		UpdateBakedLayer();
+		AcquirePooledRenderTargets();
+		const int32 NumSteps = AdvanceSimulationTime();
+		if (bWrapAroundCanvas)
 		{
-			DrawBrushes(Brushes, RTBrushDrawOn);
+			ClearExposedBuffers();
 		}
-		PostSimulate();
-		
-		//Only set when successfully updated
-		SetPreviousParameters();
+		UpdateDirtyRegions();
+		if (NumSteps == 0)
+		{
+			//No step this frame,stamps stay on RT for next step
+			FlushCollectionParameters();
+			DrawOnRTDrawOn(Brushes);
+			PublishDirtyRegions();
+		}
+		RunSimulationSteps(NumSteps, &Brushes);
 	}
 	else
 	{
@@ -111,199 +179,1983 @@ void AWorldDrawingBoard::PrepareForSimulate(TArray<UInteractBrush*> Brushes)
 
 void AWorldDrawingBoard::PrepareForSimulate()
 {
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	bParallelInstancesBuilt = false;
+	//Materials keep recovering trails while sleeping,and sample canvas that may move
+	PublishAnalyticTime();
+	PublishCanvasParameters();
+	//Baked layer is a base layer,it follows canvas even when sleeping
+	UpdateBakedLayer();
 	//No drawing,so increase TimeFromLastDraw
 	TimeFromLastDraw += GetWorld()->DeltaTimeSeconds;
-	if (TimeFromLastDraw > SleepTime && SleepTime >= 0)
+	//With analytic decay there is nothing to simulate without drawing
+	if (bAnalyticDecay || (TimeFromLastDraw > SleepTime && SleepTime >= 0))
 	{
-		// Do nothing
+		//Don't catch up sleeping time when waking up
+		SimulationTimeAccumulator = 0;
+		//Trails stay on RT while sleeping,keep them where canvas is
+		if (RTBrushDrawOn && HasCanvasMoved())
+		{
+			UpdateDirtyRegions();
+			if (bWrapAroundCanvas)
+			{
+				ClearExposedBuffers();
+				SetPreviousParameters();
+				PublishCanvasParameters();
+			}
+			else
+			{
+				//Content is shifted in steps,so take one
+				RunSimulationSteps(1, nullptr);
+			}
+		}
 	}
 	else
 	{
+		AcquirePooledRenderTargets();
+		const int32 NumSteps = AdvanceSimulationTime();
+		if (bWrapAroundCanvas)
+		{
+			ClearExposedBuffers();
+		}
+		UpdateDirtyRegions();
+		RunSimulationSteps(NumSteps, nullptr);
+	}
+}
+
+int32 AWorldDrawingBoard::AdvanceSimulationTime()
+{
+	const float DeltaTime = GetWorld()->DeltaTimeSeconds;
+	if (SimulationRate <= 0)
+	{
+		SimulationDeltaTime = DeltaTime;
+		SimulationInterpolationAlpha = 1;
+		return 1;
+	}
+	const float StepTime = 1.f / SimulationRate;
+	SimulationDeltaTime = StepTime;
+	SimulationTimeAccumulator += DeltaTime;
+	int32 NumSteps = FMath::FloorToInt(SimulationTimeAccumulator / StepTime);
+	if (NumSteps > MaxSimulationStepsPerFrame)
+	{
+		NumSteps = FMath::Max(MaxSimulationStepsPerFrame, 1);
+		SimulationTimeAccumulator = NumSteps * StepTime;
+	}
+	//Without wrap around,RT content is shifted in steps with canvas movement.
+	//Stamps drawn after canvas moved would be shifted again,so take a step now and borrow it from next steps
+	if (NumSteps == 0 && !bWrapAroundCanvas && HasCanvasMoved())
+	{
+		NumSteps = 1;
+	}
+	SimulationTimeAccumulator = FMath::Max(SimulationTimeAccumulator - NumSteps * StepTime, -StepTime);
+	SimulationInterpolationAlpha = FMath::Clamp(SimulationTimeAccumulator / StepTime, 0.f, 1.f);
+	return NumSteps;
+}
+
+bool AWorldDrawingBoard::HasCanvasMoved() const
+{
+	return !CanvasWorldLocation.Equals(PreviousCanvasWorldLocation) || CanvasWorldYaw != PreviousCanvasWorldYaw
+		|| CanvasWorldSize != PreviousCanvasWorldSize || RTSize != PreviousRTSize;
+}
+
+void AWorldDrawingBoard::RunSimulationSteps(int32 NumSteps, const TArray<UInteractBrush*>* Brushes)
+{
+	SimulationStepCount = NumSteps;
+	for (SimulationStepIndex = 0; SimulationStepIndex < NumSteps; SimulationStepIndex++)
+	{
+		if (SimulationStepIndex == 0 && HasCanvasMoved())
+		{
+			OnCanvasMoved();
+		}
+		PublishDirtyRegions();
+		FlushCollectionParameters();
 		PreSimulate();
+		if (Brushes && SimulationStepIndex == 0)
+		{
+			DrawOnRTDrawOn(*Brushes);
+			PublishDirtyRegions();
+			FlushCollectionParameters();
+		}
 		PostSimulate();
-		//Only set when successfully updated
+		//After drawing,so stamps drawn in frames without a step stay in current buffer until simulation reads them.
+		//Next buffer written by simulation becomes current,no copy
+		AdvanceRingsForStep();
+		DirtyRegions.EndFrame();
+		if (SimulationStepIndex == 0 && NumSteps > 1)
+		{
+			//Canvas movement is applied by first step,following steps must not shift again
+			SetPreviousParameters();
+			PublishCanvasParameters();
+		}
+	}
+	SimulationStepIndex = 0;
+	//Only set when successfully updated.
+	//In wrap around mode nothing is shifted,and exposed canvas is cleared every frame,so always set
+	if (NumSteps > 0 || bWrapAroundCanvas)
+	{
 		SetPreviousParameters();
 	}
 }
 
-void AWorldDrawingBoard::PreSimulate_Implementation()
+void AWorldDrawingBoard::DrawOnRTDrawOn(const TArray<UInteractBrush*>& Brushes)
 {
+	if (RTBrushDrawOn)
+	{
+		DrawBrushes(Brushes, RTBrushDrawOn);
+	}
+	else
+	{
+		//Nothing to draw on,drop instances so they will not be drawn next time
+		ResetPendingInstances();
+		bParallelInstancesBuilt = false;
+	}
 }
 
-void AWorldDrawingBoard::DrawBrushes(TArray<UInteractBrush*> Brushes, UTextureRenderTarget2D* RTDrawOn)
+void AWorldDrawingBoard::UpdateDirtyRegions()
 {
-	UCanvas* CanvasDrawOn;
-	FVector2D CanvasSize;
-	FDrawToRenderTargetContext DrawContext;
-	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, RTDrawOn, CanvasDrawOn, CanvasSize, DrawContext);
-	for (const auto Brush : Brushes)
+	if (!bTrackDirtyRegions)
 	{
-		Brush->PreDrawOnRT(this, CanvasDrawOn, CanvasSize);
+		DirtyRegions.Reset();
+		return;
 	}
-	DispatchDrawInstances(CanvasDrawOn);
-	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+	DirtyRegions.MaxRects = DirtyRegionMaxRects;
+	DirtyRegions.SettleFrames = DirtyRegionSettleFrames;
+	DirtyRegions.Padding = DirtyRegionPadding;
+	//Without wrap around,RT content is shifted with canvas,so do regions
+	if (!bWrapAroundCanvas && !CanvasWorldLocation.Equals(DirtyRegionsCanvasLocation))
+	{
+		const FVector2D CanvasOffset = UKismetMathLibrary::GetRotated2D(
+			DirtyRegionsCanvasLocation - CanvasWorldLocation, CanvasWorldYaw * -1);
+		DirtyRegions.Shift(CanvasOffset / CanvasWorldSize * RTSize);
+	}
+	DirtyRegionsCanvasLocation = CanvasWorldLocation;
 }
 
-void AWorldDrawingBoard::PostSimulate_Implementation()
+void AWorldDrawingBoard::PublishDirtyRegions()
 {
+	if (!ParameterCollection || DirtyBoundsParameterName.IsNone())
+	{
+		return;
+	}
+	FVector4 DirtyBounds;
+	if (!GetDirtyBounds(DirtyBounds))
+	{
+		//Min greater than Max,so materials can early-out everywhere
+		DirtyBounds = FVector4(1, 1, 0, 0);
+	}
+	SetCollectionVectorParameter(DirtyBoundsParameterName, FLinearColor(DirtyBounds.X, DirtyBounds.Y, DirtyBounds.Z, DirtyBounds.W));
 }
 
-void AWorldDrawingBoard::SetCanvasWorldLocation(FVector2D NewLocation, bool bPixelAligned, float PixelSizeScale)
+void AWorldDrawingBoard::PublishAnalyticTime()
 {
-	if (bPixelAligned)
+	if (!bAnalyticDecay)
 	{
-		CanvasWorldLocation = FVector2D(floor((NewLocation / (PixelWorldSize * PixelSizeScale)).X),
-		                                floor((NewLocation / (PixelWorldSize * PixelSizeScale)).Y)) * PixelWorldSize *
-			PixelSizeScale;
+		return;
 	}
-	else
+	SetCollectionVectorParameter(AnalyticTimeParameterName, FLinearColor(GetAnalyticTime(), AnalyticTimePeriod, 0, 0));
+}
+
+void AWorldDrawingBoard::PublishCanvasParameters()
+{
+	SetCollectionVectorParameter(CanvasParameterName, FLinearColor(CanvasWorldLocation.X, CanvasWorldLocation.Y,
+	                                                               CanvasWorldSize.X, CanvasWorldSize.Y));
+	SetCollectionVectorParameter(PreviousCanvasParameterName, FLinearColor(PreviousCanvasWorldLocation.X, PreviousCanvasWorldLocation.Y,
+	                                                                       PreviousCanvasWorldSize.X, PreviousCanvasWorldSize.Y));
+	SetCollectionVectorParameter(PixelParameterName, FLinearColor(PixelWorldSize.X, PixelWorldSize.Y,
+	                                                              CanvasWorldYaw, PreviousCanvasWorldYaw));
+}
+
+void AWorldDrawingBoard::SetCollectionVectorParameter(FName ParameterName, const FLinearColor& Value) const
+{
+	if (!ParameterCollection || ParameterName.IsNone())
 	{
-		CanvasWorldLocation = NewLocation;
+		return;
+	}
+	if (UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>())
+	{
+		Subsystem->SetCollectionVectorParameter(ParameterCollection, ParameterName, Value);
 	}
 }
 
-float AWorldDrawingBoard::WorldToCanvasRotation(float WorldRotation)
+void AWorldDrawingBoard::FlushCollectionParameters() const
 {
-	return WorldRotation - CanvasWorldYaw;
+	if (!ParameterCollection)
+	{
+		return;
+	}
+	if (UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>())
+	{
+		Subsystem->FlushCollectionParameters();
+	}
 }
 
-FVector2D AWorldDrawingBoard::WorldToCanvasSize(FVector2D WorldSize)
+bool AWorldDrawingBoard::HasAnalyticContent() const
 {
-	return WorldSize / PixelWorldSize;
+	//AnalyticTimePeriod is longer than the longest recovery,so nothing is left after it
+	return bAnalyticDecay && GetActiveState() && TimeFromLastDraw < AnalyticTimePeriod;
 }
 
-FVector2D AWorldDrawingBoard::WorldToCanvasUV(FVector2D WorldLocation)
+float AWorldDrawingBoard::GetAnalyticTime() const
 {
-	return UKismetMathLibrary::GetRotated2D((WorldLocation - CanvasWorldLocation) / CanvasWorldSize,
-	                                        CanvasWorldYaw * -1) + FVector2D(0.5, 0.5);
+	//Wrap in double,world time loses precision in float after hours
+	return static_cast<float>(FMath::Fmod(GetWorld()->GetTimeSeconds(), static_cast<double>(FMath::Max(AnalyticTimePeriod, 1.f))));
 }
 
-float AWorldDrawingBoard::GetNearestDistance(FVector2D WorldLocation) const
+void AWorldDrawingBoard::UpdatePooledRenderTargets(float DeltaTime)
 {
-	FVector2D DistanceVector = UKismetMathLibrary::GetRotated2D(WorldLocation - CanvasWorldLocation,
-	                                                            CanvasWorldYaw * -1);
-	DistanceVector = FVector2D(FMath::Abs(DistanceVector.X), FMath::Abs(DistanceVector.Y)) - CanvasWorldSize;
-	return FVector2D(FMath::Max(DistanceVector.X, 0), FMath::Max(DistanceVector.Y, 0)).Length();
+	UpdateContentSaves();
+	//Analytic trails are still recovering in materials after the board sleeps,releasing would drop them
+	if (GetIsSimulating() || HasAnalyticContent())
+	{
+		TimeFromLastSimulate = 0;
+		return;
+	}
+	TimeFromLastSimulate += DeltaTime;
+	if (ReleaseRenderTargetsDelay >= 0 && TimeFromLastSimulate > ReleaseRenderTargetsDelay)
+	{
+		ReleasePooledRenderTargets(true);
+	}
 }
 
-void AWorldDrawingBoard::WorldToCanvasBrush(FVector2D BrushLocation, FVector2D BrushSize, float BrushRotation,
-                                            FVector2D& OutScreenPosition, FVector2D& OutScreenSize,
-                                            float& OutScreenRotation)
+void AWorldDrawingBoard::AcquirePooledRenderTargets()
 {
-	OutScreenSize = WorldToCanvasSize(BrushSize);
-	OutScreenPosition = WorldToCanvasUV(BrushLocation) * RTSize - OutScreenSize / 2;
-	OutScreenRotation = WorldToCanvasRotation(BrushRotation);
+	if ((PooledRenderTargetSlots.Num() == 0 && RenderTargetRings.Num() == 0) || GetRenderTargetsAcquired())
+	{
+		return;
+	}
+	UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>();
+	SavedRenderTargetContents.SetNum(PooledRenderTargetSlots.Num());
+	for (int32 i = 0; i < PooledRenderTargetSlots.Num(); i++)
+	{
+		const FIWPooledRenderTargetSlot& Slot = PooledRenderTargetSlots[i];
+		//Acquired again before its content is saved,the content is still there
+		UTextureRenderTarget2D* RenderTarget = TakeSavingRenderTarget(i);
+		if (!RenderTarget)
+		{
+			RenderTarget = Subsystem->AcquireRenderTarget(
+				FMath::RoundToInt(RTSize.X), FMath::RoundToInt(RTSize.Y), Slot.Format, Slot.ClearColor);
+			if (Slot.bKeepContent && SavedRenderTargetContents[i].Num() > 0)
+			{
+				RestoreRenderTargetContent(RenderTarget, SavedRenderTargetContents[i]);
+			}
+		}
+		PooledRenderTargets.Add(RenderTarget);
+		SavedRenderTargetContents[i].Empty();
+		if (Slot.bDrawOn)
+		{
+			SetRTDrawOn(RenderTarget);
+		}
+	}
+	RingFirstBuffers.Reset();
+	RingCurrentBuffers.Reset();
+	for (const auto& Ring : RenderTargetRings)
+	{
+		RingFirstBuffers.Add(RingRenderTargets.Num());
+		RingCurrentBuffers.Add(0);
+		for (int32 i = 0; i < FMath::Max(Ring.NumBuffers, 1); i++)
+		{
+			RingRenderTargets.Add(Subsystem->AcquireRenderTarget(
+				FMath::RoundToInt(RTSize.X), FMath::RoundToInt(RTSize.Y), Ring.Format, Ring.ClearColor));
+		}
+	}
+	UpdateRingParameters();
+	OnRenderTargetsAcquired();
 }
 
-void AWorldDrawingBoard::ResetUseInteractVolume(bool NewUseInteractVolume)
+UTextureRenderTarget2D* AWorldDrawingBoard::GetRingRenderTarget(FName RingName, int32 Age) const
 {
-	if (bUseInteractVolume == NewUseInteractVolume)
+	for (int32 RingIndex = 0; RingIndex < RenderTargetRings.Num(); RingIndex++)
 	{
-		return;
+		if (RenderTargetRings[RingIndex].Name == RingName)
+		{
+			return GetRingBuffer(RingIndex, Age);
+		}
 	}
-	bUseInteractVolume = NewUseInteractVolume;
-	ReBindInteractVolumes(bUseInteractVolume);
+	return nullptr;
 }
 
-void AWorldDrawingBoard::ResetInteractVolumes(TArray<AWorldInteractVolume*> NewInteractVolumes)
+UTextureRenderTarget2D* AWorldDrawingBoard::GetRingBuffer(int32 RingIndex, int32 Age) const
 {
-	ReBindInteractVolumes(false);
-	InteractVolumes = NewInteractVolumes;
-	ReBindInteractVolumes(true);
+	if (!RingCurrentBuffers.IsValidIndex(RingIndex))
+	{
+		return nullptr;
+	}
+	const int32 NumBuffers = FMath::Max(RenderTargetRings[RingIndex].NumBuffers, 1);
+	if (Age < 0 || Age >= NumBuffers)
+	{
+		return nullptr;
+	}
+	const int32 Buffer = (RingCurrentBuffers[RingIndex] - Age + NumBuffers) % NumBuffers;
+	return RingRenderTargets[RingFirstBuffers[RingIndex] + Buffer];
 }
 
-void AWorldDrawingBoard::InteractVolumeActive(bool bNewActive, AWorldInteractVolume* TargetInteractVolume)
+void AWorldDrawingBoard::RotateRing(int32 RingIndex)
 {
-	if (!bUseInteractVolume)
+	if (RingCurrentBuffers.IsValidIndex(RingIndex))
 	{
-		return;
+		RingCurrentBuffers[RingIndex] = (RingCurrentBuffers[RingIndex] + 1) % FMath::Max(RenderTargetRings[RingIndex].NumBuffers, 1);
 	}
-	if (bNewActive)
+}
+
+void AWorldDrawingBoard::AdvanceRenderTargetRing(FName RingName)
+{
+	for (int32 RingIndex = 0; RingIndex < RenderTargetRings.Num(); RingIndex++)
 	{
-		ActiveVolumes.AddUnique(TargetInteractVolume);
+		if (RenderTargetRings[RingIndex].Name == RingName)
+		{
+			RotateRing(RingIndex);
+		}
 	}
-	else
+	UpdateRingParameters();
+}
+
+void AWorldDrawingBoard::AdvanceRingsForStep()
+{
+	bool bAnyRotated = false;
+	for (int32 RingIndex = 0; RingIndex < RenderTargetRings.Num(); RingIndex++)
 	{
-		ActiveVolumes.Remove(TargetInteractVolume);
+		if (RenderTargetRings[RingIndex].bAdvanceEachStep && RingCurrentBuffers.IsValidIndex(RingIndex))
+		{
+			RotateRing(RingIndex);
+			bAnyRotated = true;
+		}
+	}
+	if (bAnyRotated)
+	{
+		UpdateRingParameters();
 	}
-	UpdateActive();
 }
 
-void AWorldDrawingBoard::SetDrawingBoardActive(bool NewActive)
+void AWorldDrawingBoard::UpdateRingParameters()
 {
-	bActive = NewActive;
-	UpdateActive();
+	RingMaterials.Remove(nullptr);
+	for (int32 RingIndex = 0; RingIndex < RenderTargetRings.Num() && RingCurrentBuffers.IsValidIndex(RingIndex); RingIndex++)
+	{
+		const FIWRenderTargetRing& Ring = RenderTargetRings[RingIndex];
+		for (int32 Age = 0; Age < Ring.TextureParameterNames.Num(); Age++)
+		{
+			UTextureRenderTarget2D* RenderTarget = GetRingBuffer(RingIndex, Age);
+			if (!RenderTarget || Ring.TextureParameterNames[Age].IsNone())
+			{
+				continue;
+			}
+			for (const auto Material : RingMaterials)
+			{
+				Material->SetTextureParameterValue(Ring.TextureParameterNames[Age], RenderTarget);
+			}
+		}
+		if (Ring.bDrawOn)
+		{
+			SetRTDrawOn(GetRingBuffer(RingIndex, 0));
+		}
+	}
 }
 
-bool AWorldDrawingBoard::GetIsSimulating()
+void AWorldDrawingBoard::RegisterRingMaterial(UMaterialInstanceDynamic* Material)
 {
-	return GetActiveState() && (SleepTime < 0 || SleepTime >= TimeFromLastDraw);
+	if (Material && !RingMaterials.Contains(Material))
+	{
+		RingMaterials.Add(Material);
+		UpdateRingParameters();
+	}
 }
 
-void AWorldDrawingBoard::SetRTDrawOn(UTextureRenderTarget2D* NewRT)
+void AWorldDrawingBoard::UnregisterRingMaterial(UMaterialInstanceDynamic* Material)
 {
-	if(!NewRT)
+	RingMaterials.Remove(Material);
+}
+
+void AWorldDrawingBoard::ReleasePooledRenderTargets(bool bKeepContent)
+{
+	if (!GetRenderTargetsAcquired())
+	{
 		return;
-	RTBrushDrawOn = NewRT;
-	RTSize = FVector2d(static_cast<float>(RTBrushDrawOn->SizeX),static_cast<float>(RTBrushDrawOn->SizeY));
-	PixelWorldSize = CanvasWorldSize/RTSize;
+	}
+	OnRenderTargetsReleased();
+	UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>();
+	SavedRenderTargetContents.SetNum(PooledRenderTargetSlots.Num());
+	for (int32 i = 0; i < PooledRenderTargets.Num(); i++)
+	{
+		UTextureRenderTarget2D* RenderTarget = PooledRenderTargets[i];
+		if (RTBrushDrawOn == RenderTarget)
+		{
+			RTBrushDrawOn = nullptr;
+		}
+		//Returned to pool after its content is read back
+		if (bKeepContent && PooledRenderTargetSlots.IsValidIndex(i) && PooledRenderTargetSlots[i].bKeepContent
+			&& BeginSaveRenderTargetContent(i, RenderTarget))
+		{
+			continue;
+		}
+		if (Subsystem)
+		{
+			Subsystem->ReleaseRenderTarget(RenderTarget);
+		}
+	}
+	PooledRenderTargets.Reset();
+	for (const auto RenderTarget : RingRenderTargets)
+	{
+		if (RTBrushDrawOn == RenderTarget)
+		{
+			RTBrushDrawOn = nullptr;
+		}
+		if (Subsystem)
+		{
+			Subsystem->ReleaseRenderTarget(RenderTarget);
+		}
+	}
+	RingRenderTargets.Reset();
+	RingFirstBuffers.Reset();
+	RingCurrentBuffers.Reset();
+	//Content is cleared or restored later,brushes draw again
+	ResetStampFingerprints();
 }
 
-void AWorldDrawingBoard::AddBrushInstance(UMaterialInterface* RenderMaterial, FVector2D ScreenPosition,
-	FVector2D ScreenSize, FVector2D CoordinatePosition, FVector2D CoordinateSize, float Rotation, FVector2D PivotPoint, FLinearColor VertexColor)
+//Readback of a released RenderTarget.Render thread copies pixels out once GPU is done,a worker compresses them
+class FIWContentReadback
 {
-	FVector2D Vertex0 = ScreenPosition;
-	FVector2D Vertex1 = ScreenPosition + ScreenSize*FVector2D(1,0);
-	FVector2D Vertex2 = ScreenPosition + ScreenSize*FVector2D(0,1);
-	FVector2D Vertex3 = ScreenPosition + ScreenSize*FVector2D(1,1);
-	const FVector2D DrawPivot = FVector2D(UKismetMathLibrary::Lerp(Vertex0.X,Vertex1.X,PivotPoint.X),UKismetMathLibrary::Lerp(Vertex0.Y,Vertex1.Y,PivotPoint.Y));
-	Vertex0 = UKismetMathLibrary::GetRotated2D(Vertex0 - DrawPivot,Rotation) + DrawPivot;
-	Vertex1 = UKismetMathLibrary::GetRotated2D(Vertex1 - DrawPivot,Rotation) + DrawPivot;
-	Vertex2 = UKismetMathLibrary::GetRotated2D(Vertex2 - DrawPivot,Rotation) + DrawPivot;
-	Vertex3 = UKismetMathLibrary::GetRotated2D(Vertex3 - DrawPivot,Rotation) + DrawPivot;
-
-	FCanvasUVTri Tri0 = FCanvasUVTri();
-	Tri0.V0_Pos = Vertex0;
-	Tri0.V1_Pos = Vertex1;
-	Tri0.V2_Pos = Vertex2;
-	Tri0.V0_UV = CoordinatePosition;
-	Tri0.V1_UV = CoordinatePosition + CoordinateSize*FVector2D(1,0);
-	Tri0.V2_UV = CoordinatePosition + CoordinateSize*FVector2D(0,1);
-	Tri0.V0_Color = VertexColor;
-	Tri0.V1_Color = VertexColor;
-	Tri0.V2_Color = VertexColor;
+public:
+	FIWContentReadback(int32 InSlotIndex, int32 InSizeX, int32 InSizeY, EPixelFormat InFormat)
+		: Readback(TEXT("IWSaveRenderTargetContent")), SlotIndex(InSlotIndex), SizeX(InSizeX), SizeY(InSizeY), Format(InFormat)
+	{
+	}
 
-	FCanvasUVTri Tri1 = FCanvasUVTri();
-	Tri1.V0_Pos = Vertex3;
-	Tri1.V1_Pos = Vertex2;
-	Tri1.V2_Pos = Vertex1;
-	Tri1.V0_UV = CoordinatePosition + CoordinateSize*FVector2D(1,1);
-	Tri1.V1_UV = CoordinatePosition + CoordinateSize*FVector2D(0,1);
-	Tri1.V2_UV = CoordinatePosition + CoordinateSize*FVector2D(1,0);
-	Tri1.V0_Color = VertexColor;
-	Tri1.V1_Color = VertexColor;
-	Tri1.V2_Color = VertexColor;
-	
-	FIWTriangleList& AimTriangleList = TriangleInstancesMap.FindOrAdd(RenderMaterial);
-	AimTriangleList.Triangles.Add(Tri0);
-	AimTriangleList.Triangles.Add(Tri1);
+	FRHIGPUTextureReadback Readback;
+	const int32 SlotIndex;
+	const int32 SizeX;
+	const int32 SizeY;
+	const EPixelFormat Format;
+	//Render thread only,pixels are copied out once
+	bool bCopied = false;
+	//Set by worker after Content is written
+	std::atomic<bool> bSaved{false};
+	TArray<uint8> Content;
+};
+
+//Pixels are kept in format of RenderTarget,so restoring doesn't lose value range
+static void CompressRenderTargetContent(const TArray<uint8>& Pixels, TArray<uint8>& OutContent)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Pixels.Num());
+	OutContent.SetNumUninitialized(CompressedSize);
+	if (FCompression::CompressMemory(NAME_Zlib, OutContent.GetData(), CompressedSize, Pixels.GetData(), Pixels.Num()))
+	{
+		OutContent.SetNum(CompressedSize);
+	}
+	else
+	{
+		OutContent.Reset();
+	}
 }
 
-void AWorldDrawingBoard::DispatchDrawInstances(UCanvas* CanvasDrawOn)
+bool AWorldDrawingBoard::BeginSaveRenderTargetContent(int32 SlotIndex, UTextureRenderTarget2D* RenderTarget)
 {
-	if (CanvasDrawOn && TriangleInstancesMap.Num()>0)
+	FTextureRenderTargetResource* Resource = RenderTarget ? RenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+	if (!Resource)
+	{
+		return false;
+	}
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	TSharedPtr<FIWContentReadback, ESPMode::ThreadSafe> ContentReadback = MakeShared<FIWContentReadback, ESPMode::ThreadSafe>(
+		SlotIndex, RenderTarget->SizeX, RenderTarget->SizeY, RenderTarget->GetFormat());
+	//RenderTarget is kept out of pool until saved,so nothing draws on it before the copy
+	ENQUEUE_RENDER_COMMAND(IWSaveRenderTargetContent)([ContentReadback, Resource](FRHICommandListImmediate& RHICmdList)
+	{
+		ContentReadback->Readback.EnqueueCopy(RHICmdList, Resource->GetRenderTargetTexture());
+	});
+	SavingRenderTargets.Add(RenderTarget);
+	ContentReadbacks.Add(ContentReadback);
+	return true;
+}
+
+void AWorldDrawingBoard::UpdateContentSaves()
+{
+	if (ContentReadbacks.Num() == 0)
+	{
+		return;
+	}
+	UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>();
+	for (int32 i = ContentReadbacks.Num() - 1; i >= 0; i--)
 	{
-		for (auto& Elem :TriangleInstancesMap)
+		const TSharedPtr<FIWContentReadback, ESPMode::ThreadSafe> ContentReadback = ContentReadbacks[i];
+		if (!ContentReadback->bSaved)
 		{
-			if (Elem.Key && Elem.Value.Triangles.Num() > 0)
+			//Readback is only checked and locked on render thread
+			ENQUEUE_RENDER_COMMAND(IWPollRenderTargetContent)([ContentReadback](FRHICommandListImmediate& RHICmdList)
 			{
-				FCanvasTriangleItem TriangleItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, NULL);
-				TriangleItem.MaterialRenderProxy = Elem.Key->GetRenderProxy();
-				UE_LOG(LogTemp,Warning,TEXT("draw instance %d :::%d"),TriangleInstancesMap.Num(),Elem.Value.Triangles.Num() );
-				TriangleItem.TriangleList = MoveTemp(Elem.Value.Triangles);
-				CanvasDrawOn->DrawItem(TriangleItem);
-			}
+				if (ContentReadback->bCopied || !ContentReadback->Readback.IsReady())
+				{
+					return;
+				}
+				ContentReadback->bCopied = true;
+				const int32 BytesPerPixel = GPixelFormats[ContentReadback->Format].BlockBytes;
+				const int32 RowBytes = ContentReadback->SizeX * BytesPerPixel;
+				int32 RowPitchInPixels = 0;
+				const uint8* Data = static_cast<const uint8*>(ContentReadback->Readback.Lock(RowPitchInPixels));
+				TArray<uint8> Pixels;
+				Pixels.SetNumUninitialized(RowBytes * ContentReadback->SizeY);
+				for (int32 Y = 0; Y < ContentReadback->SizeY; Y++)
+				{
+					FMemory::Memcpy(Pixels.GetData() + Y * RowBytes, Data + Y * RowPitchInPixels * BytesPerPixel, RowBytes);
+				}
+				ContentReadback->Readback.Unlock();
+				//Compressing takes milliseconds,keep it off render thread
+				AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [ContentReadback, Pixels = MoveTemp(Pixels)]()
+				{
+					CompressRenderTargetContent(Pixels, ContentReadback->Content);
+					ContentReadback->bSaved = true;
+				});
+			});
+			continue;
+		}
+		if (SavedRenderTargetContents.IsValidIndex(ContentReadback->SlotIndex))
+		{
+			SavedRenderTargetContents[ContentReadback->SlotIndex] = MoveTemp(ContentReadback->Content);
+		}
+		if (Subsystem)
+		{
+			Subsystem->ReleaseRenderTarget(SavingRenderTargets[i]);
+		}
+		SavingRenderTargets.RemoveAt(i);
+		ContentReadbacks.RemoveAt(i);
+	}
+}
+
+UTextureRenderTarget2D* AWorldDrawingBoard::TakeSavingRenderTarget(int32 SlotIndex)
+{
+	const int32 Index = ContentReadbacks.IndexOfByPredicate(
+		[SlotIndex](const TSharedPtr<FIWContentReadback, ESPMode::ThreadSafe>& ContentReadback)
+		{
+			return ContentReadback->SlotIndex == SlotIndex;
+		});
+	if (Index == INDEX_NONE)
+	{
+		return nullptr;
+	}
+	UTextureRenderTarget2D* RenderTarget = SavingRenderTargets[Index];
+	const FIWPooledRenderTargetSlot& Slot = PooledRenderTargetSlots[SlotIndex];
+	//Readback still finishes on other threads,its result is dropped
+	SavingRenderTargets.RemoveAt(Index);
+	ContentReadbacks.RemoveAt(Index);
+	if (RenderTarget && RenderTarget->SizeX == FMath::RoundToInt(RTSize.X) && RenderTarget->SizeY == FMath::RoundToInt(RTSize.Y)
+		&& RenderTarget->RenderTargetFormat == Slot.Format)
+	{
+		return RenderTarget;
+	}
+	//RTSize changed meanwhile,content can not be used
+	if (UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>())
+	{
+		Subsystem->ReleaseRenderTarget(RenderTarget);
+	}
+	return nullptr;
+}
+
+void AWorldDrawingBoard::CancelContentSaves()
+{
+	UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>();
+	if (Subsystem)
+	{
+		for (const auto RenderTarget : SavingRenderTargets)
+		{
+			Subsystem->ReleaseRenderTarget(RenderTarget);
+		}
+	}
+	SavingRenderTargets.Reset();
+	ContentReadbacks.Reset();
+}
+
+void AWorldDrawingBoard::RestoreRenderTargetContent(UTextureRenderTarget2D* RenderTarget, const TArray<uint8>& Content)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	const EPixelFormat Format = RenderTarget->GetFormat();
+	const int32 BytesPerPixel = GPixelFormats[Format].BlockBytes;
+	const int32 RawSize = RenderTarget->SizeX * RenderTarget->SizeY * BytesPerPixel;
+	//Freed by render thread after uploaded
+	uint8* Pixels = static_cast<uint8*>(FMemory::Malloc(RawSize));
+	if (!FCompression::UncompressMemory(NAME_Zlib, Pixels, RawSize, Content.GetData(), Content.Num()))
+	{
+		//RTSize changed while sleeping,content can not be used
+		FMemory::Free(Pixels);
+		return;
+	}
+	if (!RestoreContentTexture || RestoreContentTexture->GetSizeX() != RenderTarget->SizeX
+		|| RestoreContentTexture->GetSizeY() != RenderTarget->SizeY || RestoreContentTexture->GetPixelFormat() != Format)
+	{
+		RestoreContentTexture = UTexture2D::CreateTransient(RenderTarget->SizeX, RenderTarget->SizeY, Format);
+		if (!RestoreContentTexture)
+		{
+			FMemory::Free(Pixels);
+			return;
+		}
+		RestoreContentTexture->SRGB = false;
+		RestoreContentTexture->Filter = TF_Nearest;
+		RestoreContentTexture->UpdateResource();
+	}
+	//Upload to existing resource,commands run before drawing below
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, RenderTarget->SizeX, RenderTarget->SizeY);
+	RestoreContentTexture->UpdateTextureRegions(0, 1, Region, RenderTarget->SizeX * BytesPerPixel, BytesPerPixel, Pixels,
+	                                            [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+	                                            {
+		                                            FMemory::Free(SrcData);
+		                                            delete Regions;
+	                                            });
+
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, RenderTarget, CanvasDrawOn, CanvasSize, DrawContext);
+	FCanvasTileItem TileItem(FVector2D::ZeroVector, RestoreContentTexture->GetResource(), CanvasSize, FLinearColor::White);
+	TileItem.BlendMode = SE_BLEND_Opaque;
+	CanvasDrawOn->DrawItem(TileItem);
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+}
+
+void AWorldDrawingBoard::UpdateRenderTargetScale(float NewRTScale)
+{
+	if (!bFollowScalability)
+	{
+		return;
+	}
+	//RTSize set since last update,by "Set RT Draw On" or Blueprint,is in current scale
+	if (FullRTSize.IsZero() || RTSize != ScaledRTSize)
+	{
+		FullRTSize = RTSize / RTScale;
+	}
+	RTScale = NewRTScale;
+	const int32 SizeX = FMath::Max(FMath::RoundToInt(FullRTSize.X * RTScale), 1);
+	const int32 SizeY = FMath::Max(FMath::RoundToInt(FullRTSize.Y * RTScale), 1);
+	if (FMath::RoundToInt(RTSize.X) == SizeX && FMath::RoundToInt(RTSize.Y) == SizeY)
+	{
+		ScaledRTSize = RTSize;
+		return;
+	}
+
+	TArray<UTextureRenderTarget2D*> RenderTargets;
+	GetRenderTargets(RenderTargets);
+	//Baked layer is composited again with new size
+	RenderTargets.Remove(BakedLayerRT);
+	RenderTargets.Remove(BakedLayerShiftRT);
+	for (const auto RenderTarget : RenderTargets)
+	{
+		UInteractiveWorldBPLibrary::ResizeRenderTarget2DKeepContent(this, RenderTarget, SizeX, SizeY);
+	}
+	//Also used by pooled RenderTargets acquired later
+	RTSize = FVector2D(SizeX, SizeY);
+	ScaledRTSize = RTSize;
+	PixelWorldSize = CanvasWorldSize / RTSize;
+	//Content is resampled,so last frame is already in new resolution
+	PreviousRTSize = RTSize;
+	PreviousPixelWorldSize = PixelWorldSize;
+	if (bTrackDirtyRegions)
+	{
+		//Rects are in old pixels,let simulation run on whole RT once
+		DirtyRegions.Reset();
+		DirtyRegions.AddRect(FBox2D(FVector2D::ZeroVector, RTSize));
+	}
+	//Resampled stamps are blurred,let brushes draw sharp ones again
+	ResetStampFingerprints();
+	OnRenderTargetsResized();
+}
+
+void AWorldDrawingBoard::OnRenderTargetsResized_Implementation()
+{
+}
+
+void AWorldDrawingBoard::OnRenderTargetsAcquired_Implementation()
+{
+}
+
+void AWorldDrawingBoard::OnRenderTargetsReleased_Implementation()
+{
+}
+
+void AWorldDrawingBoard::UpdateBakedLayer()
+{
+	if (!BakedLayer)
+	{
+		return;
+	}
+	//Bounds of rotated canvas
+	const float AbsCos = FMath::Abs(FMath::Cos(FMath::DegreesToRadians(CanvasWorldYaw)));
+	const float AbsSin = FMath::Abs(FMath::Sin(FMath::DegreesToRadians(CanvasWorldYaw)));
+	const FVector2D HalfSize = 0.5f * FVector2D(AbsCos * CanvasWorldSize.X + AbsSin * CanvasWorldSize.Y,
+	                                            AbsSin * CanvasWorldSize.X + AbsCos * CanvasWorldSize.Y);
+	TArray<const FIWBakedTile*>& Tiles = BakedTilesInCanvas;
+	BakedLayer->GetTilesInBounds(FBox2D(CanvasWorldLocation - HalfSize, CanvasWorldLocation + HalfSize), Tiles);
+
+	//Tiles out of canvas will be garbage collected
+	for (auto It = LoadedBakedTiles.CreateIterator(); It; ++It)
+	{
+		const FIntPoint Coordinate = It.Key();
+		if (!Tiles.ContainsByPredicate([&Coordinate](const FIWBakedTile* Tile) { return Tile->Coordinate == Coordinate; }))
+		{
+			It.RemoveCurrent();
+			BakedTileResidentMips.Remove(Coordinate);
+			bBakedLayerDirty = true;
+		}
+	}
+
+	//Tiles are only drawn on canvas,texture streamer doesn't know they are used.Keep them resident for a while and refresh before it runs out
+	static constexpr float BakedTileResidentSeconds = 30.f;
+	const double Time = GetWorld()->GetTimeSeconds();
+	const bool bRefreshResidency = BakedTilesResidentTime < 0 || Time - BakedTilesResidentTime > BakedTileResidentSeconds / 2;
+	if (bRefreshResidency)
+	{
+		BakedTilesResidentTime = Time;
+	}
+
+	//Loaded tiles are picked up in later frames
+	TArray<FSoftObjectPath> TilesToLoad;
+	for (const FIWBakedTile* Tile : Tiles)
+	{
+		if (LoadedBakedTiles.Contains(Tile->Coordinate))
+		{
+			continue;
+		}
+		if (UTexture2D* Texture = Tile->Texture.Get())
+		{
+			LoadedBakedTiles.Add(Tile->Coordinate, Texture);
+			Texture->SetForceMipLevelsToBeResident(BakedTileResidentSeconds);
+			bBakedLayerDirty = true;
+		}
+		else if (!Tile->Texture.IsNull())
+		{
+			TilesToLoad.Add(Tile->Texture.ToSoftObjectPath());
+		}
+	}
+	if (TilesToLoad.Num() > 0 && !(BakedTilesLoadHandle.IsValid() && BakedTilesLoadHandle->IsLoadingInProgress()))
+	{
+		BakedTilesLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(TilesToLoad);
+	}
+
+	for (const auto& Elem : LoadedBakedTiles)
+	{
+		if (!Elem.Value)
+		{
+			continue;
+		}
+		if (bRefreshResidency)
+		{
+			Elem.Value->SetForceMipLevelsToBeResident(BakedTileResidentSeconds);
+		}
+		//Composite again only when more or less mips are resident than last time
+		const int32 ResidentMips = Elem.Value->GetNumResidentMips();
+		int32& CompositedMips = BakedTileResidentMips.FindOrAdd(Elem.Key, ResidentMips);
+		if (CompositedMips != ResidentMips)
+		{
+			CompositedMips = ResidentMips;
+			bBakedLayerDirty = true;
+		}
+	}
+
+	const FVector4 Canvas(CanvasWorldLocation.X, CanvasWorldLocation.Y, CanvasWorldSize.X, CanvasWorldSize.Y);
+	if (bBakedLayerDirty || CanvasWorldSize != FVector2D(BakedLayerCanvas.Z, BakedLayerCanvas.W) || CanvasWorldYaw != BakedLayerCanvasYaw
+		|| !BakedLayerRT || BakedLayerRT->SizeX != FMath::RoundToInt(RTSize.X) || BakedLayerRT->SizeY != FMath::RoundToInt(RTSize.Y))
+	{
+		CompositeBakedLayer();
+	}
+	else if (Canvas != BakedLayerCanvas)
+	{
+		//Following canvas only exposes edges
+		if (PrepareBakedLayerExposedRects(FVector2D(BakedLayerCanvas.X, BakedLayerCanvas.Y)))
+		{
+			CompositeBakedLayer(&BakedLayerExposedRects);
+		}
+		else
+		{
+			CompositeBakedLayer();
+		}
+	}
+	bBakedLayerDirty = false;
+	BakedLayerCanvas = Canvas;
+	BakedLayerCanvasYaw = CanvasWorldYaw;
+}
+
+bool AWorldDrawingBoard::PrepareBakedLayerExposedRects(const FVector2D& OldLocation)
+{
+	BakedLayerExposedRects.Reset();
+	if (bWrapAroundCanvas)
+	{
+		//Tiles stay at the same pixels,only clear and draw what is new
+		GetExposedPixelRects(OldLocation, CanvasWorldSize, RTSize, BakedLayerExposedRects);
+		return BakedLayerExposedRects.Num() == 0 || !(BakedLayerExposedRects[0] == FBox2D(FVector2D::ZeroVector, RTSize));
+	}
+	if (CanvasWorldYaw != 0)
+	{
+		//Tiles aren't axis aligned on canvas,they can't be clipped to rects
+		return false;
+	}
+	//Content moves with canvas,only shift it when canvas moved whole pixels
+	const FVector2D PixelOffset = (OldLocation - CanvasWorldLocation) / CanvasWorldSize * RTSize;
+	const FVector2D WholePixelOffset(FMath::RoundToDouble(PixelOffset.X), FMath::RoundToDouble(PixelOffset.Y));
+	if (!PixelOffset.Equals(WholePixelOffset, 0.01) || FMath::Abs(WholePixelOffset.X) >= RTSize.X || FMath::Abs(WholePixelOffset.Y) >= RTSize.Y)
+	{
+		return false;
+	}
+	ShiftRenderTargetContent(BakedLayerRT, WholePixelOffset, BakedLayerShiftRT);
+	//Columns shifted in,full height
+	double KeptMinX = 0;
+	double KeptMaxX = RTSize.X;
+	if (WholePixelOffset.X > 0)
+	{
+		BakedLayerExposedRects.Add(FBox2D(FVector2D(0, 0), FVector2D(WholePixelOffset.X, RTSize.Y)));
+		KeptMinX = WholePixelOffset.X;
+	}
+	else if (WholePixelOffset.X < 0)
+	{
+		BakedLayerExposedRects.Add(FBox2D(FVector2D(RTSize.X + WholePixelOffset.X, 0), RTSize));
+		KeptMaxX = RTSize.X + WholePixelOffset.X;
+	}
+	//Rows shifted in,only inside kept columns
+	if (WholePixelOffset.Y > 0)
+	{
+		BakedLayerExposedRects.Add(FBox2D(FVector2D(KeptMinX, 0), FVector2D(KeptMaxX, WholePixelOffset.Y)));
+	}
+	else if (WholePixelOffset.Y < 0)
+	{
+		BakedLayerExposedRects.Add(FBox2D(FVector2D(KeptMinX, RTSize.Y + WholePixelOffset.Y), FVector2D(KeptMaxX, RTSize.Y)));
+	}
+	return true;
+}
+
+//Add two triangles of an axis aligned tile quad,UVs of its corners are UVMin and UVMax
+static void AddTileQuad(TArray<FCanvasUVTri>& Triangles, const FVector2D (&QuadVertices)[4], const FVector2D& UVMin, const FVector2D& UVMax)
+{
+	FCanvasUVTri& Tri0 = Triangles.AddDefaulted_GetRef();
+	Tri0.V0_Pos = QuadVertices[0];
+	Tri0.V1_Pos = QuadVertices[1];
+	Tri0.V2_Pos = QuadVertices[2];
+	Tri0.V0_UV = UVMin;
+	Tri0.V1_UV = FVector2D(UVMax.X, UVMin.Y);
+	Tri0.V2_UV = FVector2D(UVMin.X, UVMax.Y);
+	FCanvasUVTri& Tri1 = Triangles.AddDefaulted_GetRef();
+	Tri1.V0_Pos = QuadVertices[3];
+	Tri1.V1_Pos = QuadVertices[2];
+	Tri1.V2_Pos = QuadVertices[1];
+	Tri1.V0_UV = UVMax;
+	Tri1.V1_UV = FVector2D(UVMin.X, UVMax.Y);
+	Tri1.V2_UV = FVector2D(UVMax.X, UVMin.Y);
+}
+
+void AWorldDrawingBoard::CompositeBakedLayer(const TArray<FBox2D>* PixelRects)
+{
+	if (PixelRects && PixelRects->Num() == 0)
+	{
+		return;
+	}
+	const int32 SizeX = FMath::Max(FMath::RoundToInt(RTSize.X), 1);
+	const int32 SizeY = FMath::Max(FMath::RoundToInt(RTSize.Y), 1);
+	if (!PixelRects)
+	{
+		if (!BakedLayerRT)
+		{
+			BakedLayerRT = UKismetRenderingLibrary::CreateRenderTarget2D(this, SizeX, SizeY, RTF_RGBA8, BakedLayer->ClearColor);
+		}
+		else if (BakedLayerRT->SizeX != SizeX || BakedLayerRT->SizeY != SizeY)
+		{
+			BakedLayerRT->ResizeTarget(SizeX, SizeY);
+		}
+		UKismetRenderingLibrary::ClearRenderTarget2D(this, BakedLayerRT, BakedLayer->ClearColor);
+		if (LoadedBakedTiles.Num() == 0)
+		{
+			return;
+		}
+	}
+
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, BakedLayerRT, CanvasDrawOn, CanvasSize, DrawContext);
+	if (PixelRects)
+	{
+		//Content left from where canvas was
+		for (const FBox2D& PixelRect : *PixelRects)
+		{
+			FCanvasTileItem ClearItem(PixelRect.Min, GWhiteTexture, PixelRect.GetSize(), BakedLayer->ClearColor);
+			ClearItem.BlendMode = SE_BLEND_Opaque;
+			CanvasDrawOn->DrawItem(ClearItem);
+		}
+	}
+	for (const auto& Elem : LoadedBakedTiles)
+	{
+		if (!Elem.Value || !Elem.Value->GetResource())
+		{
+			continue;
+		}
+		const FBox2D TileBounds = BakedLayer->GetTileBounds(Elem.Key);
+		const FVector2D Corners[4] = {
+			TileBounds.Min, FVector2D(TileBounds.Max.X, TileBounds.Min.Y),
+			FVector2D(TileBounds.Min.X, TileBounds.Max.Y), TileBounds.Max
+		};
+		FVector2D Vertices[4];
+		for (int32 i = 0; i < 4; i++)
+		{
+			//In wrap around mode,place tile near RT and let ForEachWrappedQuad wrap it
+			Vertices[i] = bWrapAroundCanvas ? Corners[i] / CanvasWorldSize * RTSize : WorldToCanvasUV(Corners[i]) * RTSize;
+		}
+		if (bWrapAroundCanvas)
+		{
+			const FVector2D WrapOffset = FVector2D(FMath::FloorToDouble(Vertices[0].X / RTSize.X),
+			                                       FMath::FloorToDouble(Vertices[0].Y / RTSize.Y)) * RTSize;
+			for (auto& Vertex : Vertices)
+			{
+				Vertex -= WrapOffset;
+			}
+		}
+
+		TArray<FCanvasUVTri>& Triangles = BakedLayerTriangles;
+		Triangles.Reset();
+		ForEachWrappedQuad(Vertices, bWrapAroundCanvas, RTSize, [&Triangles, PixelRects](const FVector2D (&QuadVertices)[4])
+		{
+			if (!PixelRects)
+			{
+				AddTileQuad(Triangles, QuadVertices, FVector2D(0, 0), FVector2D(1, 1));
+				return;
+			}
+			//Tile is axis aligned here,clip it to each rect
+			const FBox2D QuadBounds(QuadVertices[0], QuadVertices[3]);
+			for (const FBox2D& PixelRect : *PixelRects)
+			{
+				const FBox2D Clipped(FVector2D(FMath::Max(QuadBounds.Min.X, PixelRect.Min.X), FMath::Max(QuadBounds.Min.Y, PixelRect.Min.Y)),
+				                     FVector2D(FMath::Min(QuadBounds.Max.X, PixelRect.Max.X), FMath::Min(QuadBounds.Max.Y, PixelRect.Max.Y)));
+				if (Clipped.Min.X >= Clipped.Max.X || Clipped.Min.Y >= Clipped.Max.Y)
+				{
+					continue;
+				}
+				const FVector2D ClippedVertices[4] = {
+					Clipped.Min, FVector2D(Clipped.Max.X, Clipped.Min.Y), FVector2D(Clipped.Min.X, Clipped.Max.Y), Clipped.Max
+				};
+				AddTileQuad(Triangles, ClippedVertices, (Clipped.Min - QuadBounds.Min) / QuadBounds.GetSize(),
+				            (Clipped.Max - QuadBounds.Min) / QuadBounds.GetSize());
+			}
+		});
+		if (Triangles.Num() == 0)
+		{
+			continue;
+		}
+		FCanvasTriangleItem TriangleItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, Elem.Value->GetResource());
+		TriangleItem.BlendMode = SE_BLEND_Opaque;
+		//Lend the list like DispatchDrawInstances,copying it would allocate
+		Swap(TriangleItem.TriangleList, Triangles);
+		CanvasDrawOn->DrawItem(TriangleItem);
+		Swap(TriangleItem.TriangleList, Triangles);
+	}
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+}
+
+void AWorldDrawingBoard::BakeLayer()
+{
+#if WITH_EDITOR
+	UWorld* World = GetWorld();
+	if (!BakedLayer || !World)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: Set Baked Layer before baking"), *GetName());
+		return;
+	}
+
+	//Brushes that should be baked on this DrawingBoard
+	TArray<UInteractBrush*> BakeBrushes;
+	FBox2D BakeBounds(ForceInit);
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		TArray<UInteractBrush*> ActorBrushes;
+		It->GetComponents<UInteractBrush>(ActorBrushes);
+		for (const auto Brush : ActorBrushes)
+		{
+			if (Brush->bBakeToLayer
+				&& (!Brush->bUseDrawOnlyDrawingBoardsClassList || Brush->DrawOnlyDrawingBoardsClassList.Contains(GetClass()))
+				&& Brush->PrepareForBake())
+			{
+				BakeBrushes.Add(Brush);
+				const FVector2D Location = UInteractiveWorldBPLibrary::Vector3ToVector2(Brush->GetComponentLocation());
+				BakeBounds += FBox2D(Location - Brush->GetCullRadius(), Location + Brush->GetCullRadius());
+			}
+		}
+	}
+	if (BakeBrushes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: No brush to bake"), *GetName());
+		return;
+	}
+
+	//Draw as if canvas is each tile
+	const FVector2D SavedRTSize = RTSize;
+	const FVector2D SavedPixelWorldSize = PixelWorldSize;
+	const FVector2D SavedCanvasWorldLocation = CanvasWorldLocation;
+	const FVector2D SavedCanvasWorldSize = CanvasWorldSize;
+	const float SavedCanvasWorldYaw = CanvasWorldYaw;
+	const bool bSavedWrapAroundCanvas = bWrapAroundCanvas;
+	const bool bSavedTrackDirtyRegions = bTrackDirtyRegions;
+	const bool bSavedElideRepeatedStamps = bElideRepeatedStamps;
+	RTSize = FVector2D(BakedLayer->TileResolution, BakedLayer->TileResolution);
+	CanvasWorldSize = FVector2D(BakedLayer->TileWorldSize, BakedLayer->TileWorldSize);
+	PixelWorldSize = CanvasWorldSize / RTSize;
+	CanvasWorldYaw = 0;
+	bWrapAroundCanvas = false;
+	bTrackDirtyRegions = false;
+	//BakeRT is cleared for every tile
+	bElideRepeatedStamps = false;
+
+	UTextureRenderTarget2D* BakeRT = UKismetRenderingLibrary::CreateRenderTarget2D(
+		this, BakedLayer->TileResolution, BakedLayer->TileResolution, RTF_RGBA8, BakedLayer->ClearColor);
+	const FString PackageFolder = FPackageName::GetLongPackagePath(BakedLayer->GetOutermost()->GetName());
+	const FIntPoint MinTile = BakedLayer->GetTileCoordinate(BakeBounds.Min);
+	const FIntPoint MaxTile = BakedLayer->GetTileCoordinate(BakeBounds.Max);
+	TArray<UInteractBrush*> TileBrushes;
+	for (int32 Y = MinTile.Y; Y <= MaxTile.Y; Y++)
+	{
+		for (int32 X = MinTile.X; X <= MaxTile.X; X++)
+		{
+			const FIntPoint Coordinate(X, Y);
+			CanvasWorldLocation = BakedLayer->GetTileBounds(Coordinate).GetCenter();
+			TileBrushes.Reset();
+			for (const auto Brush : BakeBrushes)
+			{
+				if (GetNearestDistance(UInteractiveWorldBPLibrary::Vector3ToVector2(Brush->GetComponentLocation())) < Brush->GetCullRadius())
+				{
+					TileBrushes.Add(Brush);
+				}
+			}
+			if (TileBrushes.Num() == 0)
+			{
+				continue;
+			}
+			UKismetRenderingLibrary::ClearRenderTarget2D(this, BakeRT, BakedLayer->ClearColor);
+			DrawBrushes(TileBrushes, BakeRT);
+
+			//Update texture baked last time,or create a new one
+			const FString TextureName = FString::Printf(TEXT("%s_Tile_%d_%d"), *BakedLayer->GetName(), X, Y);
+			UPackage* Package = CreatePackage(*(PackageFolder / TextureName));
+			UTexture2D* Texture = FindObject<UTexture2D>(Package, *TextureName);
+			const bool bNewTexture = Texture == nullptr;
+			if (bNewTexture)
+			{
+				Texture = BakeRT->ConstructTexture2D(Package, TextureName, RF_Public | RF_Standalone);
+			}
+			else
+			{
+				BakeRT->UpdateTexture2D(Texture, TSF_BGRA8);
+			}
+			if (!Texture)
+			{
+				continue;
+			}
+			Texture->SRGB = false;
+			Texture->CompressionSettings = TC_Default;
+			Texture->MipGenSettings = TMGS_FromTextureGroup;
+			Texture->LODGroup = TEXTUREGROUP_World;
+			Texture->PostEditChange();
+			Package->MarkPackageDirty();
+			if (bNewTexture)
+			{
+				FAssetRegistryModule::AssetCreated(Texture);
+			}
+			BakedLayer->FindOrAddTile(Coordinate).Texture = Texture;
+		}
+	}
+	BakedLayer->MarkPackageDirty();
+
+	RTSize = SavedRTSize;
+	PixelWorldSize = SavedPixelWorldSize;
+	CanvasWorldLocation = SavedCanvasWorldLocation;
+	CanvasWorldSize = SavedCanvasWorldSize;
+	CanvasWorldYaw = SavedCanvasWorldYaw;
+	bWrapAroundCanvas = bSavedWrapAroundCanvas;
+	bTrackDirtyRegions = bSavedTrackDirtyRegions;
+	bElideRepeatedStamps = bSavedElideRepeatedStamps;
+	LoadedBakedTiles.Reset();
+	BakedTileResidentMips.Reset();
+	bBakedLayerDirty = true;
+#endif
+}
+
+UTextureRenderTarget2D* AWorldDrawingBoard::GetPooledRenderTarget(FName SlotName) const
+{
+	for (int32 i = 0; i < PooledRenderTargets.Num(); i++)
+	{
+		if (PooledRenderTargetSlots.IsValidIndex(i) && PooledRenderTargetSlots[i].Name == SlotName)
+		{
+			return PooledRenderTargets[i];
+		}
+	}
+	return nullptr;
+}
+
+void AWorldDrawingBoard::PreSimulate_Implementation()
+{
+}
+
+void AWorldDrawingBoard::DrawBrushes(const TArray<UInteractBrush*>& Brushes, UTextureRenderTarget2D* RTDrawOn)
+{
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, RTDrawOn, CanvasDrawOn, CanvasSize, DrawContext);
+	DrawBrushesOnCanvas(Brushes, CanvasDrawOn, CanvasSize);
+	DispatchDrawInstances(CanvasDrawOn);
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+}
+
+void AWorldDrawingBoard::CacheAccumulativeMaterials(TMap<const UMaterialInterface*, bool>& Cache) const
+{
+	//Lists are kept while their material keeps drawing,so materials of native brushes are known after their first frame
+	for (const auto& Elem : TriangleInstancesMap)
+	{
+		UInteractStampMaterialData::CacheIsAccumulative(Cache, Elem.Key);
+	}
+}
+
+void AWorldDrawingBoard::BuildParallelInstances(const TArray<UInteractBrush*>& Brushes,
+                                                const TMap<const UMaterialInterface*, bool>& AccumulativeMaterials)
+{
+	//LLM scope is per thread,worker threads need their own
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	ParallelDrawnBrushes.Init(false, Brushes.Num());
+	for (int32 i = 0; i < Brushes.Num(); i++)
+	{
+		const UInteractBrush* Brush = Brushes[i];
+		if (Brush->CanDrawInParallel())
+		{
+			ParallelDrawnBrushes[i] = DrawBrushWithElision(
+				Brush, [this, Brush]() { return Brush->PreDrawOnBoardNative(this); }, &AccumulativeMaterials);
+		}
+	}
+	bParallelInstancesBuilt = true;
+}
+
+void AWorldDrawingBoard::DrawBrushesOnCanvas(const TArray<UInteractBrush*>& Brushes, UCanvas* CanvasDrawOn,
+                                             FVector2D CanvasSize)
+{
+	for (int32 i = 0; i < Brushes.Num(); i++)
+	{
+		UInteractBrush* Brush = Brushes[i];
+		if (bParallelInstancesBuilt && Brush->CanDrawInParallel())
+		{
+			if (ParallelDrawnBrushes.IsValidIndex(i) && ParallelDrawnBrushes[i])
+			{
+				Brush->MarkDrawnThisTime();
+			}
+		}
+		//Needs Blueprint,draw on game thread.Elided brushes count as drawn
+		else if (DrawBrushWithElision(Brush, [&]() { return Brush->PreDrawOnRT(this, CanvasDrawOn, CanvasSize); }))
+		{
+			Brush->MarkDrawnThisTime();
+		}
+	}
+	bParallelInstancesBuilt = false;
+}
+
+void AWorldDrawingBoard::ShiftRenderTargetContent(UTextureRenderTarget2D* RenderTarget, FVector2D PixelOffset,
+                                                  UTextureRenderTarget2D*& ScratchRT)
+{
+	if (!RenderTarget || PixelOffset.IsZero())
+	{
+		return;
+	}
+	const FVector2D Size(RenderTarget->SizeX, RenderTarget->SizeY);
+	if (FMath::Abs(PixelOffset.X) >= Size.X || FMath::Abs(PixelOffset.Y) >= Size.Y)
+	{
+		//Moved out of RT,nothing can be kept
+		UKismetRenderingLibrary::ClearRenderTarget2D(this, RenderTarget, RenderTarget->ClearColor);
+		return;
+	}
+	if (!ScratchRT || ScratchRT->SizeX != RenderTarget->SizeX || ScratchRT->SizeY != RenderTarget->SizeY
+		|| ScratchRT->RenderTargetFormat != RenderTarget->RenderTargetFormat)
+	{
+		ScratchRT = UKismetRenderingLibrary::CreateRenderTarget2D(
+			this, RenderTarget->SizeX, RenderTarget->SizeY, RenderTarget->RenderTargetFormat, RenderTarget->ClearColor);
+	}
+	UKismetRenderingLibrary::ClearRenderTarget2D(this, ScratchRT, RenderTarget->ClearColor);
+
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, ScratchRT, CanvasDrawOn, CanvasSize, DrawContext);
+	FCanvasTileItem ShiftedItem(PixelOffset, RenderTarget->GetResource(), Size, FLinearColor::White);
+	ShiftedItem.BlendMode = SE_BLEND_Opaque;
+	CanvasDrawOn->DrawItem(ShiftedItem);
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, RenderTarget, CanvasDrawOn, CanvasSize, DrawContext);
+	FCanvasTileItem CopyItem(FVector2D::ZeroVector, ScratchRT->GetResource(), Size, FLinearColor::White);
+	CopyItem.BlendMode = SE_BLEND_Opaque;
+	CanvasDrawOn->DrawItem(CopyItem);
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+}
+
+//Hash Value rounded to Step,so changes smaller than half a Step give the same hash
+static uint32 HashQuantized(uint32 Hash, double Value, double Step)
+{
+	return HashCombine(Hash, GetTypeHash(FMath::FloorToDouble(Value / Step + 0.5)));
+}
+
+static uint32 HashQuantized(uint32 Hash, const FVector2D& Value, const FVector2D& Step)
+{
+	return HashQuantized(HashQuantized(Hash, Value.X, Step.X), Value.Y, Step.Y);
+}
+
+//Texture coordinates are hashed in 1/256,colors in 8 bits
+static const FVector2D CoordinateHashStep(1.0 / 256, 1.0 / 256);
+
+static uint32 HashVertexAttributes(uint32 Hash, const FVector2D& UV, const FLinearColor& Color)
+{
+	return HashCombine(HashQuantized(Hash, UV, CoordinateHashStep), GetTypeHash(Color.ToFColor(false)));
+}
+
+//Vertices are in pixels of canvas
+static uint32 HashTriangle(uint32 Hash, const FCanvasUVTri& Triangle)
+{
+	Hash = HashVertexAttributes(HashQuantized(Hash, Triangle.V0_Pos, FVector2D::UnitVector), Triangle.V0_UV, Triangle.V0_Color);
+	Hash = HashVertexAttributes(HashQuantized(Hash, Triangle.V1_Pos, FVector2D::UnitVector), Triangle.V1_UV, Triangle.V1_Color);
+	return HashVertexAttributes(HashQuantized(Hash, Triangle.V2_Pos, FVector2D::UnitVector), Triangle.V2_UV, Triangle.V2_Color);
+}
+
+uint32 AWorldDrawingBoard::GetCanvasFingerprint() const
+{
+	uint32 Hash = HashQuantized(0, CanvasWorldLocation, PixelWorldSize);
+	Hash = HashQuantized(Hash, CanvasWorldYaw, 0.01);
+	return HashQuantized(Hash, RTSize, FVector2D::UnitVector);
+}
+
+bool AWorldDrawingBoard::DrawBrushWithElision(const UInteractBrush* Brush, TFunctionRef<bool()> Draw,
+                                              const TMap<const UMaterialInterface*, bool>* AccumulativeMaterials)
+{
+	//Blueprint "Draw on RT" may draw on canvas directly,what it drew is unknown
+	if (!bElideRepeatedStamps || !Brush->CanDrawInParallel() || PixelWorldSize.X <= 0 || PixelWorldSize.Y <= 0)
+	{
+		return Draw();
+	}
+	const TObjectKey<UInteractBrush> BrushKey(Brush);
+	uint32 Fingerprint = GetCanvasFingerprint();
+	auto IsAccumulative = [AccumulativeMaterials](const UMaterialInterface* Material)
+	{
+		if (!AccumulativeMaterials)
+		{
+			return UInteractStampMaterialData::IsAccumulative(Material);
+		}
+		const bool* bAccumulative = AccumulativeMaterials->Find(Material);
+		return !bAccumulative || *bAccumulative;
+	};
+
+	if (Brush->HasWorldStampCache())
+	{
+		//Stamps are known before drawing,so no triangle is built for an elided brush
+		bool bElidable = true;
+		for (const FIWWorldStamp& Stamp : Brush->GetWorldStamps())
+		{
+			if (IsAccumulative(Stamp.Material))
+			{
+				bElidable = false;
+				break;
+			}
+			Fingerprint = HashCombine(Fingerprint, GetTypeHash(Stamp.Material));
+			Fingerprint = HashQuantized(Fingerprint, Stamp.Location, PixelWorldSize);
+			Fingerprint = HashQuantized(Fingerprint, Stamp.Size, PixelWorldSize);
+			Fingerprint = HashQuantized(Fingerprint, Stamp.Rotation, 1);
+			Fingerprint = HashQuantized(Fingerprint, Stamp.CoordinatePosition, CoordinateHashStep);
+			Fingerprint = HashQuantized(Fingerprint, Stamp.CoordinateSize, CoordinateHashStep);
+			Fingerprint = HashCombine(Fingerprint, GetTypeHash(Stamp.VertexColor.ToFColor(false)));
+		}
+		if (!bElidable)
+		{
+			StampFingerprints.Remove(BrushKey);
+			return Draw();
+		}
+		//Only drawn stamps are remembered,so an elided brush is always on canvas
+		const uint32* LastFingerprint = StampFingerprints.Find(BrushKey);
+		if (LastFingerprint && *LastFingerprint == Fingerprint)
+		{
+			return true;
+		}
+		if (!Draw())
+		{
+			StampFingerprints.Remove(BrushKey);
+			return false;
+		}
+		SetStampFingerprint(Brush, Fingerprint);
+		return true;
+	}
+
+	//Native brushes are fingerprinted by triangles they added,an elided brush still builds them but costs no fill
+	FingerprintListStarts.Reset();
+	for (const auto& Elem : TriangleInstancesMap)
+	{
+		FingerprintListStarts.Emplace(Elem.Key, Elem.Value.Triangles.Num());
+	}
+	auto GetListStart = [this](const UMaterialInterface* Material)
+	{
+		const TPair<UMaterialInterface*, int32>* Start = FingerprintListStarts.FindByPredicate(
+			[Material](const TPair<UMaterialInterface*, int32>& Pair) { return Pair.Key == Material; });
+		return Start ? Start->Value : 0;
+	};
+	//Quads are only marked dirty once brush is known to be drawn,an elided brush doesn't widen dirty regions
+	DeferredDirtyRects.Reset();
+	bDeferDirtyRects = true;
+	const bool bDrawn = Draw();
+	bDeferDirtyRects = false;
+	if (!bDrawn)
+	{
+		StampFingerprints.Remove(BrushKey);
+		return false;
+	}
+	auto MarkDeferredDirtyRects = [this]()
+	{
+		if (DeferredDirtyRects.Num() > 0)
+		{
+			UpdateDirtyRegions();
+			for (const FBox2D& Rect : DeferredDirtyRects)
+			{
+				DirtyRegions.AddRect(Rect);
+			}
+		}
+	};
+
+	for (const auto& Elem : TriangleInstancesMap)
+	{
+		const int32 Start = GetListStart(Elem.Key);
+		if (Elem.Value.Triangles.Num() <= Start)
+		{
+			continue;
+		}
+		if (IsAccumulative(Elem.Key))
+		{
+			StampFingerprints.Remove(BrushKey);
+			MarkDeferredDirtyRects();
+			return true;
+		}
+		uint32 ListHash = GetTypeHash(Elem.Key);
+		for (int32 i = Start; i < Elem.Value.Triangles.Num(); i++)
+		{
+			ListHash = HashTriangle(ListHash, Elem.Value.Triangles[i]);
+		}
+		//Order of lists in map may change between frames,so lists are summed
+		Fingerprint += ListHash;
+	}
+	const uint32* LastFingerprint = StampFingerprints.Find(BrushKey);
+	if (!LastFingerprint || *LastFingerprint != Fingerprint)
+	{
+		SetStampFingerprint(Brush, Fingerprint);
+		MarkDeferredDirtyRects();
+		return true;
+	}
+	for (auto& Elem : TriangleInstancesMap)
+	{
+		Elem.Value.Triangles.SetNum(GetListStart(Elem.Key), false);
+	}
+	return true;
+}
+
+void AWorldDrawingBoard::SetStampFingerprint(const UInteractBrush* Brush, uint32 Fingerprint)
+{
+	StampFingerprints.Add(TObjectKey<UInteractBrush>(Brush), Fingerprint);
+	if (StampFingerprints.Num() > StampFingerprintsPruneSize)
+	{
+		for (auto It = StampFingerprints.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().ResolveObjectPtr())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		StampFingerprintsPruneSize = FMath::Max(64, StampFingerprints.Num() * 2);
+	}
+}
+
+void AWorldDrawingBoard::PostSimulate_Implementation()
+{
+}
+
+void AWorldDrawingBoard::SetCanvasWorldLocation(FVector2D NewLocation, bool bPixelAligned, float PixelSizeScale)
+{
+	if (bPixelAligned)
+	{
+		CanvasWorldLocation = FVector2D(floor((NewLocation / (PixelWorldSize * PixelSizeScale)).X),
+		                                floor((NewLocation / (PixelWorldSize * PixelSizeScale)).Y)) * PixelWorldSize *
+			PixelSizeScale;
+	}
+	else
+	{
+		CanvasWorldLocation = NewLocation;
+	}
+}
+
+float AWorldDrawingBoard::WorldToCanvasRotation(float WorldRotation) const
+{
+	//Wrapped UV ignores yaw,so rotation does too.Yaw set from Blueprint after BeginPlay doesn't rotate stamps off their place
+	return bWrapAroundCanvas ? WorldRotation : WorldRotation - CanvasWorldYaw;
+}
+
+FVector2D AWorldDrawingBoard::WorldToCanvasSize(FVector2D WorldSize) const
+{
+	return WorldSize / PixelWorldSize;
+}
+
+FVector2D AWorldDrawingBoard::WorldToCanvasUV(FVector2D WorldLocation) const
+{
+	if (bWrapAroundCanvas)
+	{
+		//Anchored to world,so the same location always uses the same pixel wherever canvas is
+		const FVector2D WrappedUV = WorldLocation / CanvasWorldSize;
+		return WrappedUV - FVector2D(FMath::Floor(WrappedUV.X), FMath::Floor(WrappedUV.Y));
+	}
+	return UKismetMathLibrary::GetRotated2D((WorldLocation - CanvasWorldLocation) / CanvasWorldSize,
+	                                        CanvasWorldYaw * -1) + FVector2D(0.5, 0.5);
+}
+
+void AWorldDrawingBoard::GetExposedCanvasPixelRects(TArray<FBox2D>& OutRects) const
+{
+	GetExposedPixelRects(PreviousCanvasWorldLocation, PreviousCanvasWorldSize, PreviousRTSize, OutRects);
+}
+
+void AWorldDrawingBoard::GetExposedPixelRects(const FVector2D& OldLocation, const FVector2D& OldSize, const FVector2D& OldRTSize,
+                                              TArray<FBox2D>& OutRects) const
+{
+	OutRects.Reset();
+	if (!bWrapAroundCanvas)
+	{
+		return;
+	}
+	const FBox2D NewRect(CanvasWorldLocation - CanvasWorldSize / 2, CanvasWorldLocation + CanvasWorldSize / 2);
+	const FBox2D OldRect(OldLocation - OldSize / 2, OldLocation + OldSize / 2);
+	if (!CanvasWorldSize.Equals(OldSize) || !RTSize.Equals(OldRTSize) || !NewRect.Intersect(OldRect))
+	{
+		//Nothing can be kept
+		OutRects.Add(FBox2D(FVector2D::ZeroVector, RTSize));
+		return;
+	}
+
+	//Columns that old canvas didn't cover,full height
+	if (NewRect.Min.X < OldRect.Min.X)
+	{
+		AddWrappedPixelRects(FBox2D(NewRect.Min, FVector2D(OldRect.Min.X, NewRect.Max.Y)), OutRects);
+	}
+	else if (NewRect.Max.X > OldRect.Max.X)
+	{
+		AddWrappedPixelRects(FBox2D(FVector2D(OldRect.Max.X, NewRect.Min.Y), NewRect.Max), OutRects);
+	}
+	//Rows that old canvas didn't cover,only inside columns that old canvas covered
+	const float OverlapMinX = FMath::Max(NewRect.Min.X, OldRect.Min.X);
+	const float OverlapMaxX = FMath::Min(NewRect.Max.X, OldRect.Max.X);
+	if (NewRect.Min.Y < OldRect.Min.Y)
+	{
+		AddWrappedPixelRects(FBox2D(FVector2D(OverlapMinX, NewRect.Min.Y), FVector2D(OverlapMaxX, OldRect.Min.Y)), OutRects);
+	}
+	else if (NewRect.Max.Y > OldRect.Max.Y)
+	{
+		AddWrappedPixelRects(FBox2D(FVector2D(OverlapMinX, OldRect.Max.Y), FVector2D(OverlapMaxX, NewRect.Max.Y)), OutRects);
+	}
+}
+
+TArray<FVector4> AWorldDrawingBoard::GetExposedCanvasRects() const
+{
+	TArray<FBox2D> PixelRects;
+	GetExposedCanvasPixelRects(PixelRects);
+	TArray<FVector4> Rects;
+	for (const auto& PixelRect : PixelRects)
+	{
+		Rects.Add(FVector4(PixelRect.Min.X, PixelRect.Min.Y, PixelRect.GetSize().X, PixelRect.GetSize().Y));
+	}
+	return Rects;
+}
+
+void AWorldDrawingBoard::ClearExposedCanvas(UTextureRenderTarget2D* RenderTarget)
+{
+	GetExposedCanvasPixelRects(ExposedPixelRects);
+	ClearPixelRects(RenderTarget, ExposedPixelRects, WrapClearColor);
+}
+
+void AWorldDrawingBoard::ClearExposedBuffers()
+{
+	GetExposedCanvasPixelRects(ExposedPixelRects);
+	if (ExposedPixelRects.Num() == 0)
+	{
+		return;
+	}
+	ClearPixelRects(RTBrushDrawOn, ExposedPixelRects, WrapClearColor);
+	//Older buffers of rings are read by simulation,they must not keep content of the other side of canvas
+	for (const auto RenderTarget : RingRenderTargets)
+	{
+		if (RenderTarget && RenderTarget != RTBrushDrawOn)
+		{
+			ClearPixelRects(RenderTarget, ExposedPixelRects, RenderTarget->ClearColor);
+		}
+	}
+}
+
+void AWorldDrawingBoard::ClearPixelRects(UTextureRenderTarget2D* RenderTarget, const TArray<FBox2D>& PixelRects,
+                                         const FLinearColor& ClearColor)
+{
+	if (!RenderTarget || PixelRects.Num() == 0)
+	{
+		return;
+	}
+	UCanvas* CanvasDrawOn;
+	FVector2D CanvasSize;
+	FDrawToRenderTargetContext DrawContext;
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, RenderTarget, CanvasDrawOn, CanvasSize, DrawContext);
+	//RenderTarget may not be the same size as RTDrawOn
+	const FVector2D PixelScale = CanvasSize / RTSize;
+	for (const auto& PixelRect : PixelRects)
+	{
+		FCanvasTileItem TileItem(PixelRect.Min * PixelScale, GWhiteTexture, PixelRect.GetSize() * PixelScale, ClearColor);
+		TileItem.BlendMode = SE_BLEND_Opaque;
+		CanvasDrawOn->DrawItem(TileItem);
+	}
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, DrawContext);
+}
+
+void AWorldDrawingBoard::AddWrappedPixelRects(const FBox2D& WorldRect, TArray<FBox2D>& OutRects) const
+{
+	if (WorldRect.GetSize().X <= 0 || WorldRect.GetSize().Y <= 0)
+	{
+		return;
+	}
+	//Round outward to whole pixels
+	const FVector2D PixelMin = WorldToCanvasUV(WorldRect.Min) * RTSize;
+	const FVector2D PixelSize = WorldRect.GetSize() / CanvasWorldSize * RTSize;
+	const FVector2D Start(FMath::FloorToDouble(PixelMin.X), FMath::FloorToDouble(PixelMin.Y));
+	const FVector2D End(FMath::CeilToDouble(PixelMin.X + PixelSize.X), FMath::CeilToDouble(PixelMin.Y + PixelSize.Y));
+
+	//Split at RT edges,each axis has at most two segments
+	auto SplitAxis = [](double SegmentStart, double SegmentEnd, double AxisSize, FVector2D (&OutSegments)[2])-> int32
+	{
+		SegmentEnd = FMath::Min(SegmentEnd, SegmentStart + AxisSize);
+		if (SegmentEnd <= AxisSize)
+		{
+			OutSegments[0] = FVector2D(SegmentStart, SegmentEnd);
+			return 1;
+		}
+		OutSegments[0] = FVector2D(SegmentStart, AxisSize);
+		OutSegments[1] = FVector2D(0, SegmentEnd - AxisSize);
+		return 2;
+	};
+	FVector2D SegmentsX[2];
+	FVector2D SegmentsY[2];
+	const int32 NumX = SplitAxis(Start.X, End.X, RTSize.X, SegmentsX);
+	const int32 NumY = SplitAxis(Start.Y, End.Y, RTSize.Y, SegmentsY);
+	for (int32 y = 0; y < NumY; y++)
+	{
+		for (int32 x = 0; x < NumX; x++)
+		{
+			OutRects.Add(FBox2D(FVector2D(SegmentsX[x].X, SegmentsY[y].X), FVector2D(SegmentsX[x].Y, SegmentsY[y].Y)));
+		}
+	}
+}
+
+float AWorldDrawingBoard::GetNearestDistance(FVector2D WorldLocation) const
+{
+	FVector2D DistanceVector = UKismetMathLibrary::GetRotated2D(WorldLocation - CanvasWorldLocation,
+	                                                            CanvasWorldYaw * -1);
+	DistanceVector = FVector2D(FMath::Abs(DistanceVector.X), FMath::Abs(DistanceVector.Y)) - CanvasWorldSize;
+	return FVector2D(FMath::Max(DistanceVector.X, 0), FMath::Max(DistanceVector.Y, 0)).Length();
+}
+
+void AWorldDrawingBoard::WorldToCanvasBrush(FVector2D BrushLocation, FVector2D BrushSize, float BrushRotation,
+                                            FVector2D& OutScreenPosition, FVector2D& OutScreenSize,
+                                            float& OutScreenRotation)
+{
+	OutScreenSize = WorldToCanvasSize(BrushSize);
+	OutScreenPosition = WorldToCanvasUV(BrushLocation) * RTSize - OutScreenSize / 2;
+	OutScreenRotation = WorldToCanvasRotation(BrushRotation);
+}
+
+void AWorldDrawingBoard::MarkBrushAreaDirty(FVector2D FromLocation, FVector2D ToLocation, float Radius)
+{
+	if (!bTrackDirtyRegions)
+	{
+		return;
+	}
+	UpdateDirtyRegions();
+	const FVector2D HalfExtent = WorldToCanvasSize(FVector2D(Radius));
+	for (const FVector2D& Location : {FromLocation, ToLocation})
+	{
+		const FVector2D ScreenCenter = WorldToCanvasUV(Location) * RTSize;
+		const FVector2D Vertices[4] = {
+			ScreenCenter - HalfExtent, FVector2D(ScreenCenter.X + HalfExtent.X, ScreenCenter.Y - HalfExtent.Y),
+			FVector2D(ScreenCenter.X - HalfExtent.X, ScreenCenter.Y + HalfExtent.Y), ScreenCenter + HalfExtent
+		};
+		ForEachWrappedQuad(Vertices, bWrapAroundCanvas, RTSize, [this](const FVector2D (&QuadVertices)[4])
+		{
+			DirtyRegions.AddRect(FBox2D(QuadVertices, 4));
+		});
+	}
+}
+
+TArray<FVector4> AWorldDrawingBoard::GetDirtyRects() const
+{
+	TArray<FBox2D> PixelRects;
+	DirtyRegions.GetDirtyRects(FBox2D(FVector2D::ZeroVector, RTSize), PixelRects);
+	TArray<FVector4> Rects;
+	for (const auto& PixelRect : PixelRects)
+	{
+		Rects.Add(FVector4(PixelRect.Min / RTSize, PixelRect.Max / RTSize));
+	}
+	return Rects;
+}
+
+bool AWorldDrawingBoard::GetDirtyBounds(FVector4& OutBounds) const
+{
+	const FBox2D PixelBounds = DirtyRegions.GetDirtyBounds(FBox2D(FVector2D::ZeroVector, RTSize));
+	if (!PixelBounds.bIsValid)
+	{
+		OutBounds = FVector4(0, 0, 0, 0);
+		return false;
+	}
+	OutBounds = FVector4(PixelBounds.Min / RTSize, PixelBounds.Max / RTSize);
+	return true;
+}
+
+void AWorldDrawingBoard::ResetUseInteractVolume(bool NewUseInteractVolume)
+{
+	if (bUseInteractVolume == NewUseInteractVolume)
+	{
+		return;
+	}
+	bUseInteractVolume = NewUseInteractVolume;
+	ReBindInteractVolumes(bUseInteractVolume);
+}
+
+void AWorldDrawingBoard::ResetInteractVolumes(TArray<AWorldInteractVolume*> NewInteractVolumes)
+{
+	ReBindInteractVolumes(false);
+	InteractVolumes = NewInteractVolumes;
+	ReBindInteractVolumes(true);
+}
+
+void AWorldDrawingBoard::InteractVolumeActive(bool bNewActive, AWorldInteractVolume* TargetInteractVolume)
+{
+	if (!bUseInteractVolume)
+	{
+		return;
+	}
+	if (bNewActive)
+	{
+		ActiveVolumes.AddUnique(TargetInteractVolume);
+	}
+	else
+	{
+		ActiveVolumes.Remove(TargetInteractVolume);
+	}
+	UpdateActive();
+}
+
+void AWorldDrawingBoard::SetDrawingBoardActive(bool NewActive)
+{
+	bActive = NewActive;
+	UpdateActive();
+}
+
+bool AWorldDrawingBoard::GetIsSimulating() const
+{
+	if (bAnalyticDecay)
+	{
+		//Only simulating in frames that draw
+		return GetActiveState() && TimeFromLastDraw <= 0;
+	}
+	return GetActiveState() && (SleepTime < 0 || SleepTime >= TimeFromLastDraw);
+}
+
+void AWorldDrawingBoard::SetRTDrawOn(UTextureRenderTarget2D* NewRT)
+{
+	if(!NewRT)
+		return;
+	RTBrushDrawOn = NewRT;
+	RTSize = FVector2d(static_cast<float>(RTBrushDrawOn->SizeX),static_cast<float>(RTBrushDrawOn->SizeY));
+	PixelWorldSize = CanvasWorldSize/RTSize;
+}
+
+//Rotate 4 corners of a quad around pivot,sin and cos are calculated once.
+//Corners are packed as [x0,y0,x1,y1],so two registers hold the whole quad.
+//Unless bFullPivot,pivot Y is on top edge of quad whatever PivotPoint.Y is,like former versions
+static void ExpandQuad(const FVector2D& ScreenPosition, const FVector2D& ScreenSize, float Rotation,
+                       const FVector2D& PivotPoint, bool bFullPivot, FVector2D (&OutVertices)[4])
+{
+	double Sin, Cos;
+	FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(static_cast<double>(Rotation)));
+
+	const FVector2D PivotOffset(ScreenSize.X * PivotPoint.X, bFullPivot ? ScreenSize.Y * PivotPoint.Y : 0);
+	const FVector2D DrawPivot = ScreenPosition + PivotOffset;
+	const VectorRegister4Double CosReg = VectorSetFloat1(Cos);
+	const VectorRegister4Double SinReg = MakeVectorRegisterDouble(-Sin, Sin, -Sin, Sin);
+	const VectorRegister4Double PivotReg = MakeVectorRegisterDouble(DrawPivot.X, DrawPivot.Y, DrawPivot.X, DrawPivot.Y);
+
+	//Corners relative to pivot
+	const double Left = -PivotOffset.X;
+	const double Top = -PivotOffset.Y;
+	const double Right = Left + ScreenSize.X;
+	const double Bottom = Top + ScreenSize.Y;
+	const VectorRegister4Double TopCorners = MakeVectorRegisterDouble(Left, Top, Right, Top);
+	const VectorRegister4Double BottomCorners = MakeVectorRegisterDouble(Left, Bottom, Right, Bottom);
+
+	//x' = x*cos - y*sin, y' = y*cos + x*sin
+	const VectorRegister4Double RotatedTop = VectorMultiplyAdd(TopCorners, CosReg, VectorMultiplyAdd(VectorSwizzle(TopCorners, 1, 0, 3, 2), SinReg, PivotReg));
+	const VectorRegister4Double RotatedBottom = VectorMultiplyAdd(BottomCorners, CosReg, VectorMultiplyAdd(VectorSwizzle(BottomCorners, 1, 0, 3, 2), SinReg, PivotReg));
+
+	double Packed[8];
+	VectorStore(RotatedTop, Packed);
+	VectorStore(RotatedBottom, Packed + 4);
+	OutVertices[0] = FVector2D(Packed[0], Packed[1]);
+	OutVertices[1] = FVector2D(Packed[2], Packed[3]);
+	OutVertices[2] = FVector2D(Packed[4], Packed[5]);
+	OutVertices[3] = FVector2D(Packed[6], Packed[7]);
+}
+
+void AWorldDrawingBoard::AddBrushInstance(UMaterialInterface* RenderMaterial, FVector2D ScreenPosition,
+	FVector2D ScreenSize, FVector2D CoordinatePosition, FVector2D CoordinateSize, float Rotation, FVector2D PivotPoint, FLinearColor VertexColor)
+{
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	FVector2D Vertices[4];
+	ExpandQuad(ScreenPosition, ScreenSize, Rotation, PivotPoint, bRotateAroundPivotPoint, Vertices);
+	AddQuad(TriangleInstancesMap.FindOrAdd(RenderMaterial), Vertices, CoordinatePosition, CoordinateSize, VertexColor);
+}
+
+void AWorldDrawingBoard::AddBrushInstances(UMaterialInterface* RenderMaterial, const TArray<FIWBrushInstance>& Instances)
+{
+	if (!RenderMaterial || Instances.Num() == 0)
+	{
+		return;
+	}
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+	//Find list and grow it once for the whole batch
+	FIWTriangleList& TriangleList = TriangleInstancesMap.FindOrAdd(RenderMaterial);
+	TriangleList.Triangles.Reserve(TriangleList.Triangles.Num() + Instances.Num() * 2);
+
+	FVector2D Vertices[4];
+	for (const FIWBrushInstance& Instance : Instances)
+	{
+		ExpandQuad(Instance.ScreenPosition, Instance.ScreenSize, Instance.Rotation, Instance.PivotPoint, bRotateAroundPivotPoint, Vertices);
+		AddQuad(TriangleList, Vertices, Instance.CoordinatePosition, Instance.CoordinateSize, Instance.VertexColor);
+	}
+}
+
+void AWorldDrawingBoard::AddQuad(FIWTriangleList& TriangleList, const FVector2D (&Vertices)[4],
+                                 FVector2D CoordinatePosition, FVector2D CoordinateSize,
+                                 const FLinearColor& VertexColor)
+{
+	ForEachWrappedQuad(Vertices, bWrapAroundCanvas, RTSize, [&](const FVector2D (&QuadVertices)[4])
+	{
+		AddQuadTriangles(TriangleList, QuadVertices, CoordinatePosition, CoordinateSize, VertexColor);
+	});
+}
+
+void AWorldDrawingBoard::AddQuadTriangles(FIWTriangleList& TriangleList, const FVector2D (&Vertices)[4],
+                                          FVector2D CoordinatePosition, FVector2D CoordinateSize,
+                                          const FLinearColor& VertexColor)
+{
+	if (bTrackDirtyRegions)
+	{
+		if (bDeferDirtyRects)
+		{
+			DeferredDirtyRects.Add(FBox2D(Vertices, 4));
+		}
+		else
+		{
+			UpdateDirtyRegions();
+			DirtyRegions.AddRect(FBox2D(Vertices, 4));
+		}
+	}
+
+	//Write into the list directly,no temporary triangles
+	const int32 FirstIndex = TriangleList.Triangles.AddUninitialized(2);
+	FCanvasUVTri& Tri0 = TriangleList.Triangles[FirstIndex];
+	Tri0.V0_Pos = Vertices[0];
+	Tri0.V1_Pos = Vertices[1];
+	Tri0.V2_Pos = Vertices[2];
+	Tri0.V0_UV = CoordinatePosition;
+	Tri0.V1_UV = CoordinatePosition + CoordinateSize*FVector2D(1,0);
+	Tri0.V2_UV = CoordinatePosition + CoordinateSize*FVector2D(0,1);
+	Tri0.V0_Color = VertexColor;
+	Tri0.V1_Color = VertexColor;
+	Tri0.V2_Color = VertexColor;
+
+	FCanvasUVTri& Tri1 = TriangleList.Triangles[FirstIndex + 1];
+	Tri1.V0_Pos = Vertices[3];
+	Tri1.V1_Pos = Vertices[2];
+	Tri1.V2_Pos = Vertices[1];
+	Tri1.V0_UV = CoordinatePosition + CoordinateSize*FVector2D(1,1);
+	Tri1.V1_UV = CoordinatePosition + CoordinateSize*FVector2D(0,1);
+	Tri1.V2_UV = CoordinatePosition + CoordinateSize*FVector2D(1,0);
+	Tri1.V0_Color = VertexColor;
+	Tri1.V1_Color = VertexColor;
+	Tri1.V2_Color = VertexColor;
+}
+
+void AWorldDrawingBoard::AddStampInstances(UMaterialInterface* RenderMaterial, const TArray<FIWStamp>& Stamps)
+{
+	if (!RenderMaterial)
+	{
+		return;
+	}
+	TArray<FIWBrushInstance>& Instances = StampInstancesBuffer;
+	Instances.Reset(Stamps.Num());
+	for (const auto& Stamp : Stamps)
+	{
+		//Same culling as InteractBrush
+		if (GetNearestDistance(Stamp.Location) >= Stamp.Size.Length())
+		{
+			continue;
+		}
+		FIWBrushInstance& Instance = Instances.AddDefaulted_GetRef();
+		WorldToCanvasBrush(Stamp.Location, Stamp.Size, Stamp.Rotation, Instance.ScreenPosition, Instance.ScreenSize, Instance.Rotation);
+		Instance.VertexColor = FLinearColor(Stamp.Intensity, Stamp.Intensity, Stamp.Intensity, Stamp.Intensity);
+	}
+	AddBrushInstances(RenderMaterial, Instances);
+}
+
+int32 AWorldDrawingBoard::AddWorldStampInstances(const TArray<FIWWorldStamp>& Stamps)
+{
+	int32 NumAdded = 0;
+	for (const auto& Stamp : Stamps)
+	{
+		NumAdded += AddWorldStampInstance(Stamp) ? 1 : 0;
+	}
+	return NumAdded;
+}
+
+bool AWorldDrawingBoard::AddWorldStampInstance(const FIWWorldStamp& Stamp)
+{
+	//Same culling as InteractBrush
+	if (!Stamp.Material || GetNearestDistance(Stamp.Location) >= Stamp.Size.Length())
+	{
+		return false;
+	}
+	FVector2D ScreenPosition;
+	FVector2D ScreenSize;
+	float ScreenRotation;
+	WorldToCanvasBrush(Stamp.Location, Stamp.Size, Stamp.Rotation, ScreenPosition, ScreenSize, ScreenRotation);
+	AddBrushInstance(Stamp.Material, ScreenPosition, ScreenSize, Stamp.CoordinatePosition, Stamp.CoordinateSize,
+	                 ScreenRotation, FVector2D(0.5f, 0.5f), Stamp.VertexColor);
+	return true;
+}
+
+void AWorldDrawingBoard::DispatchDrawInstances(UCanvas* CanvasDrawOn)
+{
+	DrawPendingInstances(CanvasDrawOn);
+	ResetPendingInstances();
+}
+
+void AWorldDrawingBoard::DrawPendingInstances(UCanvas* CanvasDrawOn)
+{
+	if (!CanvasDrawOn)
+	{
+		return;
+	}
+	int32 NumTriangles = 0;
+	for (auto& Elem : TriangleInstancesMap)
+	{
+		if (Elem.Key && Elem.Value.Triangles.Num() > 0)
+		{
+			NumTriangles += Elem.Value.Triangles.Num();
+			FCanvasTriangleItem TriangleItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, NULL);
+			TriangleItem.MaterialRenderProxy = Elem.Key->GetRenderProxy();
+			//Canvas copies triangles into its batch,so lend the list and take it back with its memory
+			Swap(TriangleItem.TriangleList, Elem.Value.Triangles);
+			CanvasDrawOn->DrawItem(TriangleItem);
+			Swap(TriangleItem.TriangleList, Elem.Value.Triangles);
+		}
+	}
+	PeakTriangleCount = FMath::Max(PeakTriangleCount, NumTriangles);
+}
+
+void AWorldDrawingBoard::ResetPendingInstances()
+{
+	for (auto It = TriangleInstancesMap.CreateIterator(); It; ++It)
+	{
+		//Empty since last reset means this material stopped drawing,free its list
+		if (!It.Key() || It.Value().Triangles.Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+		else
+		{
+			It.Value().Triangles.Reset();
+		}
+	}
+}
+
+bool AWorldDrawingBoard::HasPendingInstances() const
+{
+	for (const auto& Elem : TriangleInstancesMap)
+	{
+		if (Elem.Value.Triangles.Num() > 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void AWorldDrawingBoard::GetRenderTargets(TArray<UTextureRenderTarget2D*>& OutRenderTargets) const
+{
+	if (RTBrushDrawOn)
+	{
+		OutRenderTargets.AddUnique(RTBrushDrawOn);
+	}
+	for (const auto PooledRenderTarget : PooledRenderTargets)
+	{
+		if (PooledRenderTarget)
+		{
+			OutRenderTargets.AddUnique(PooledRenderTarget);
+		}
+	}
+	for (const auto RingRenderTarget : RingRenderTargets)
+	{
+		if (RingRenderTarget)
+		{
+			OutRenderTargets.AddUnique(RingRenderTarget);
+		}
+	}
+	if (BakedLayerRT)
+	{
+		OutRenderTargets.AddUnique(BakedLayerRT);
+	}
+	if (BakedLayerShiftRT)
+	{
+		OutRenderTargets.AddUnique(BakedLayerShiftRT);
+	}
+}
+
+void AWorldDrawingBoard::GetMemoryStats(FIWDrawingBoardMemoryStats& OutStats) const
+{
+	OutStats = FIWDrawingBoardMemoryStats();
+	TArray<UTextureRenderTarget2D*> RenderTargets;
+	GetRenderTargets(RenderTargets);
+	OutStats.NumRenderTargets = RenderTargets.Num();
+	for (const auto RenderTarget : RenderTargets)
+	{
+		//Released RenderTargets hold no GPU memory
+		if (RenderTarget->GetResource())
+		{
+			OutStats.RenderTargetBytes += RenderTarget->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+		}
+	}
+
+	OutStats.InstanceBufferBytes = TriangleInstancesMap.GetAllocatedSize();
+	for (const auto& Elem : TriangleInstancesMap)
+	{
+		OutStats.InstanceBufferBytes += Elem.Value.Triangles.GetAllocatedSize();
+		OutStats.PendingTriangles += Elem.Value.Triangles.Num();
+	}
+	OutStats.PeakTriangles = PeakTriangleCount;
+
+	for (const auto& Content : SavedRenderTargetContents)
+	{
+		OutStats.SavedContentBytes += Content.GetAllocatedSize();
+	}
+	if (RestoreContentTexture)
+	{
+		OutStats.SavedContentBytes += RestoreContentTexture->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+	}
+	for (const auto& Tile : LoadedBakedTiles)
+	{
+		if (Tile.Value)
+		{
+			OutStats.NumBakedTiles++;
+			OutStats.BakedTileBytes += Tile.Value->CalcTextureMemorySizeEnum(TMC_ResidentMips);
 		}
 	}
-	TriangleInstancesMap.Empty();
+	OutStats.NumDirtyRects = DirtyRegions.Num();
+	OutStats.bSimulating = GetIsSimulating();
+	OutStats.bRenderTargetsAcquired = GetRenderTargetsAcquired();
+	OutStats.TimeFromLastDraw = TimeFromLastDraw;
 }
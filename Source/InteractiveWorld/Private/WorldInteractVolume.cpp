@@ -3,6 +3,7 @@
 #include "WorldInteractVolume.h"
 #include "InteractBrush.h"
 #include "WorldDrawingBoard.h"
+#include "InteractiveWorldSubsystem.h"
 #include "Components/BrushComponent.h"
 #include "Kismet/GameplayStatics.h"
 
@@ -33,6 +34,17 @@ void AWorldInteractVolume::BeginPlay()
  //Waiting for one frame for all overlapping finished.
  GetWorldTimerManager().SetTimerForNextTick(this,&AWorldInteractVolume::ResetActiveState);
  //ResetActiveState();
+
+ GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>()->RegisterInteractVolume(this);
+}
+
+void AWorldInteractVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+ Super::EndPlay(EndPlayReason);
+ if (UInteractiveWorldSubsystem* Subsystem = GetWorld()->GetSubsystem<UInteractiveWorldSubsystem>())
+ {
+  Subsystem->UnregisterInteractVolume(this);
+ }
 }
 
 bool AWorldInteractVolume::InteractiveBrushEnter(UInteractBrush* InteractBrush)
@@ -183,6 +195,24 @@ void AWorldInteractVolume::RemoveBrush(UInteractBrush* InteractBrush)
  UpdateDrawingBoardsActive();
 }
 
+void AWorldInteractVolume::AddOverlappingBrushes(const TArray<UInteractBrush*>& InteractBrushes)
+{
+ bool bHasSuitableBrush = false;
+ for (const auto InteractBrush : InteractBrushes)
+ {
+  //Already entered by overlap event
+  if (InteractBrush->IsInVolume(this))
+  {
+   continue;
+  }
+  bHasSuitableBrush |= InteractiveBrushEnter(InteractBrush);
+ }
+ if (bHasSuitableBrush)
+ {
+  UpdateDrawingBoardsActive();
+ }
+}
+
 void AWorldInteractVolume::ResetActiveState()
 {
  for (const auto InteractBrush : OverlappingBrushes)
@@ -0,0 +1,81 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//A capture brush wants its bounds captured
+struct FIWCaptureRequest
+{
+	//Stable id of the brush
+	int32 Id = INDEX_NONE;
+
+	//World bounds to capture
+	FBox Bounds = FBox(ForceInit);
+
+	//Distance to viewer,far requests are updated less often
+	float ViewDistance = 0;
+};
+
+//One scene capture covering one or more requests
+struct FIWCaptureJob
+{
+	//Square in XY,covers bounds of all requests
+	FBox Bounds = FBox(ForceInit);
+
+	//Index of requests in the array passed to Schedule
+	TArray<int32, TInlineAllocator<4>> RequestIndices;
+};
+
+//Decide which capture brushes to capture in this frame,and merge close ones into one capture.
+//This is a plain struct without UObject or rendering,so it can be tested without GPU.
+struct INTERACTIVEWORLD_API FIWCaptureScheduler
+{
+	//Captures in one frame,requests over budget wait for next frames with higher priority
+	int32 MaxCapturesPerFrame = 2;
+
+	//Max world size of a merged capture in XY,so frustum stays tight and resolution is not wasted
+	float MaxCaptureSize = 1000;
+
+	//Requests closer than this are merged
+	float MergeDistance = 50;
+
+	//Each this distance from viewer adds one frame between captures.If less than or equal to 0,capture every frame
+	float IntervalDistance = 2000;
+
+	//Max frames between captures of a moving brush
+	int32 MaxInterval = 8;
+
+	//Bounds moved less than this since last capture will not be captured again
+	float MovementTolerance = 1;
+
+	//Schedule captures of this frame.Requests in OutJobs are considered captured
+	void Schedule(const TArray<FIWCaptureRequest>& Requests, TArray<FIWCaptureJob>& OutJobs);
+
+	//Brush is gone,forget it
+	void Remove(int32 Id) {States.Remove(Id);}
+
+	void Reset() {States.Reset();}
+
+	//Frames to wait between captures at ViewDistance
+	int32 GetUpdateInterval(float ViewDistance) const;
+
+private:
+	struct FRequestState
+	{
+		//Invalid if never captured
+		FBox LastCapturedBounds = FBox(ForceInit);
+		int32 FramesSinceCapture = 0;
+	};
+	TMap<int32, FRequestState> States;
+
+	struct FReadyRequest
+	{
+		int32 Index;
+		//Frames waited longer than its interval,higher goes first
+		int32 Overdue;
+		float ViewDistance;
+	};
+	//Kept between frames to reuse memory
+	TArray<FReadyRequest> ReadyRequests;
+};
@@ -0,0 +1,52 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Accumulate dirty pixel rects of a DrawingBoard,so simulation can scissor or early-out outside them.
+//This is a plain struct without UObject or RHI,so it can be tested without GPU.
+struct INTERACTIVEWORLD_API FIWDirtyRegionTracker
+{
+	//Max rects kept,more will be merged into the ones that grow least
+	int32 MaxRects = 4;
+
+	//Frames a region stays dirty after last drawn,for simulation still settling
+	int32 SettleFrames = 0;
+
+	//Pixels added around each rect,for simulation spreading outward like waves
+	float Padding = 0;
+
+	//Mark a pixel rect dirty in current frame
+	void AddRect(const FBox2D& Rect);
+
+	//Finish current frame,age regions and drop the settled ones
+	void EndFrame();
+
+	//Canvas content moved,move regions with it.Offset is in pixels
+	void Shift(const FVector2D& Offset);
+
+	void Reset() {Regions.Reset();}
+
+	bool IsDirty() const {return Regions.Num() > 0;}
+
+	int32 Num() const {return Regions.Num();}
+
+	//Get dirty rects,including settling ones,clamped to Bounds
+	void GetDirtyRects(const FBox2D& Bounds, TArray<FBox2D>& OutRects) const;
+
+	//Union of all dirty rects clamped to Bounds,invalid box if nothing is dirty
+	FBox2D GetDirtyBounds(const FBox2D& Bounds) const;
+
+private:
+	struct FRegion
+	{
+		FBox2D Rect;
+		//Frames from last time this region was drawn
+		int32 Age;
+	};
+	TArray<FRegion> Regions;
+
+	//Merge regions until there are no more than MaxRects
+	void MergeToLimit();
+};
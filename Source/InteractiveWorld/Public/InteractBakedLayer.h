@@ -0,0 +1,58 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/Texture2D.h"
+#include "InteractBakedLayer.generated.h"
+
+//One baked texture covering a square of TileWorldSize in world
+USTRUCT(BlueprintType)
+struct FIWBakedTile
+{
+	GENERATED_BODY()
+
+	//Tile covers [Coordinate,Coordinate + 1) * TileWorldSize
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Baked Tile")
+	FIntPoint Coordinate = FIntPoint::ZeroValue;
+
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Baked Tile")
+	TSoftObjectPtr<UTexture2D> Texture;
+};
+
+//Static interaction baked in editor by a DrawingBoard,like paths trodden into snow.
+//DrawingBoards composite tiles around their canvas as a base layer,tiles are loaded and streamed as normal textures
+UCLASS(BlueprintType)
+class INTERACTIVEWORLD_API UInteractBakedLayer : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//World size of each tile
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Baked Layer",meta = (ClampMin = 1))
+	float TileWorldSize = 4096;
+
+	//Texture size of each tile when baking
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Baked Layer",meta = (ClampMin = 16))
+	int32 TileResolution = 1024;
+
+	//Color of area without baked brushes
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Baked Layer")
+	FLinearColor ClearColor = FLinearColor::Black;
+
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Baked Layer")
+	TArray<FIWBakedTile> Tiles;
+
+	//Tile coordinate that contains WorldLocation
+	FIntPoint GetTileCoordinate(const FVector2D& WorldLocation) const;
+
+	//World bounds of a tile
+	FBox2D GetTileBounds(const FIntPoint& Coordinate) const;
+
+	//Tiles intersecting WorldBounds
+	void GetTilesInBounds(const FBox2D& WorldBounds, TArray<const FIWBakedTile*>& OutTiles) const;
+
+	//Find tile at Coordinate,or add one
+	FIWBakedTile& FindOrAddTile(const FIntPoint& Coordinate);
+};
@@ -8,6 +8,62 @@
 #include "InteractBrush.generated.h"
 
 class AWorldDrawingBoard;
+class UInteractiveWorldSubsystem;
+class UMaterialInterface;
+
+//Result of async line trace requested by a brush,arrives in next frame
+USTRUCT(BlueprintType)
+struct FIWBrushTraceResult
+{
+	GENERATED_BODY()
+
+	//False if no trace has been requested,or physics hasn't returned the result
+	UPROPERTY(BlueprintReadOnly,Category = "Trace")
+	bool bValid = false;
+
+	UPROPERTY(BlueprintReadOnly,Category = "Trace")
+	bool bBlockingHit = false;
+
+	UPROPERTY(BlueprintReadOnly,Category = "Trace")
+	FVector ImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly,Category = "Trace")
+	FVector ImpactNormal = FVector::UpVector;
+
+	UPROPERTY(BlueprintReadOnly,Category = "Trace")
+	float Distance = 0;
+};
+
+//A quad in world space,cached by brush once per frame and transformed to canvas by each DrawingBoard
+USTRUCT(BlueprintType)
+struct FIWWorldStamp
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	UMaterialInterface* Material = nullptr;
+
+	//Stamp center in world
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FVector2D Location = FVector2D::ZeroVector;
+
+	//Stamp size in world
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FVector2D Size = FVector2D(10,10);
+
+	//Stamp yaw in world
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	float Rotation = 0;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FVector2D CoordinatePosition = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FVector2D CoordinateSize = FVector2D::UnitVector;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FLinearColor VertexColor = FLinearColor::White;
+};
 
 UCLASS(Blueprintable,ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class INTERACTIVEWORLD_API UInteractBrush : public USceneComponent
@@ -45,9 +101,13 @@ public:
 	//Drawing Mode//
 	
 	//Whether to draw every frame
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InteractBrush|DrawingMode")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetDrawEveryFrame, Category = "InteractBrush|DrawingMode")
 	bool bDrawEveryFrame = false;
 
+	//Brushes that don't draw every frame are only prepared by subsystem after they move or DrawBrush is called
+	UFUNCTION(BlueprintSetter)
+	void SetDrawEveryFrame(bool bNewDrawEveryFrame);
+
 	//Whether to draw on movement.  Disable if you are going to draw manually from blueprint.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InteractBrush|DrawingMode",meta = (editcondition = "!bDrawEveryFrame"))
 	bool bDrawOnMovement = true;
@@ -76,15 +136,54 @@ public:
 	//If bUseMultiDraw = true,drawing times will be depending on distance moved,then how far do you want each draw between
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|MultiDraw",meta = (editcondition = "bUseMultiDraw"))
 	float MaxDrawDistance = 10;
+
+	//World Stamp Cache//
+
+	//Build stamps once per frame in world space and share them between all DrawingBoards,each DrawingBoard only transforms them to its canvas.
+	//"Draw on RT" is skipped,stamps are added by "Add World Stamp" in "Build World Stamps",which is called for each MultiDraw step
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|WorldStampCache")
+	bool bCacheWorldStamps = false;
+
+	//Add a stamp to cache of this frame in "Build World Stamps".Only drawn if bCacheWorldStamps is true
+	UFUNCTION(BlueprintCallable,Category = "InteractBrush|WorldStampCache",meta=(DisplayName="Add World Stamp"))
+	void AddWorldStamp(const FIWWorldStamp& Stamp) {WorldStamps.Add(Stamp);}
+
+	//Add stamps of one MultiDraw step by "Add World Stamp".InterpolateRate goes to 1 like "Draw on RT".Called on game thread
+	UFUNCTION(BlueprintNativeEvent,Category = "InteractBrush|WorldStampCache",meta=(DisplayName="Build World Stamps"))
+	void BuildWorldStamps(float InterpolateRate, int32 DrawTimes);
+
+	//Build cache of this frame.Called by subsystem before DrawingBoards draw
+	void BuildWorldStampCache();
+
+	//Stamps are cached in this frame,DrawingBoards draw them instead of calling "Draw on RT"
+	bool HasWorldStampCache() const {return bCacheWorldStamps && WorldStampsFrame == GFrameCounter;}
+
+	//Stamps cached in this frame,only valid if HasWorldStampCache
+	const TArray<FIWWorldStamp>& GetWorldStamps() const {return WorldStamps;}
 	
+	//Baked Layer//
+
+	//Only drawn into baked layers by "Bake Layer" of DrawingBoards in editor,doesn't draw at runtime.For static interaction like paths and ruts
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|BakedLayer")
+	bool bBakeToLayer = false;
+
+	//Set transforms to where it is placed and update draw info for baking.Return false if it doesn't need to be drawn
+	bool PrepareForBake();
+
+	//CPU Wind//
+
+	//Push subsystem's CPU wind field when moving,in the size of cull radius.Set before BeginPlay
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|CPUWind")
+	bool bAffectCPUWind = false;
+
 	//Drawing//
 	
 	//Do some preparation for drawing,and return a boolean which decides whether ot need to be drawn or not 
-	bool PrepareForDrawing(TArray<TSubclassOf<AWorldDrawingBoard>>& NoVolumeDrawingBoardClass);
+	bool PrepareForDrawing(const TArray<TSubclassOf<AWorldDrawingBoard>>& NoVolumeDrawingBoardClass);
 
 	//Draw manually.If you set bDrawEveryFrame and bDrawOnMovement false,you should call this to draw
 	UFUNCTION(BlueprintCallable,Category = "InteractBrush|Drawing",meta=(DisplayName="Draw Brush"))
-	void DrawBrush(){bDrawOnce=true;};
+	void DrawBrush();
 	
 	//Function for blueprint children to override,update information and return a boolean which decides whether ot need to be drawn or not
 	UFUNCTION(BlueprintNativeEvent,Category = "InteractBrush|Drawing",meta=(DisplayName="Update Draw Info"))
@@ -93,20 +192,67 @@ public:
 	//Check if this brush should draw on specific DrawingBoard
 	bool ShouldDrawOn(AWorldDrawingBoard* DrawingBoard) const;
 
-	//Call this to let brush draw on canvas
-	void PreDrawOnRT(AWorldDrawingBoard* DrawingBoard,UCanvas* CanvasDrawOn,FVector2D CanvasSize);
+	//Call this to let brush draw on canvas.Return false if every cached stamp was culled
+	bool PreDrawOnRT(AWorldDrawingBoard* DrawingBoard,UCanvas* CanvasDrawOn,FVector2D CanvasSize);
 
 	//The actual event to draw brush.if you opened bUseMultiDraw,InterpolateRate will interpolation from 0 to 1 
 	UFUNCTION(BlueprintNativeEvent,Category = "InteractBrush|Drawing",meta=(DisplayName="Draw on RT"))
 	void DrawOnRT(AWorldDrawingBoard* DrawingBoard, UCanvas* CanvasDrawOn, FVector2D CanvasSize, float InterpolateRate, int32 DrawTimes);
 
 	void FinishDraw();
+
+	//Mark this brush need to be prepared in next tick.Return false if it has been marked
+	bool TryMarkDirty();
+	//Subsystem clears it when preparing this brush
+	void ClearDirty() {bMarkedDirty = false;}
+
+	//Native Drawing//
+
+	//Override in native brushes to add instances to DrawingBoard without Blueprint.Default "Draw on RT" calls this.
+	//If "Draw on RT" is not overridden in Blueprint,this may run on worker threads,so only read this brush and add instances to DrawingBoard
+	virtual void DrawOnBoardNative(AWorldDrawingBoard* DrawingBoard, float InterpolateRate, int32 DrawTimes) const {}
+
+	//Native brushes that implement DrawOnBoardNative should return true
+	virtual bool HasNativeDraw() const {return false;}
+
+	//If this brush can build instances on worker threads,without Blueprint
+	bool CanDrawInParallel() const {return (HasNativeDraw() && !bDrawOnRTInBlueprint) || HasWorldStampCache();}
+
+	//The same as PreDrawOnRT,but only call DrawOnBoardNative,so it can run on worker threads
+	bool PreDrawOnBoardNative(AWorldDrawingBoard* DrawingBoard) const;
+
+	//Brush has been drawn by PreDrawOnBoardNative,or by PreDrawOnRT of an elided draw
+	void MarkDrawnThisTime() {bSucceededDrawnThisTime = true;}
 	
 	//If we "PrepareForDrawing",but didn't draw successfully,it will be false.
 	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "InteractBrush|Drawing",meta=(DisplayName="Get Last Draw Succeed"))
 	bool GetLastDrawSucceed() const {return bSucceededDrawnLastTime;}
 	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "InteractBrush|Drawing",meta=(DisplayName="Get Current Draw Succeed"))
 	bool GetCurrentDrawSucceed() const {return bSucceededDrawnThisTime;}
+
+	//Async Trace//
+
+	//Request a line trace that runs with other brushes' traces off the game thread.Result can be get by "Get Trace Result" in next frame,before "Update Draw Info".
+	//Use this in "Update Draw Info" instead of synchronous line trace when brush needs to know if it touches the ground.
+	UFUNCTION(BlueprintCallable,Category = "InteractBrush|Trace",meta=(DisplayName="Request Async Line Trace"))
+	void RequestAsyncLineTrace(FVector Start, FVector End, TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility);
+
+	//Request a sphere overlap test,result can be get by "Get Overlap Result" in next frame
+	UFUNCTION(BlueprintCallable,Category = "InteractBrush|Trace",meta=(DisplayName="Request Async Overlap"))
+	void RequestAsyncOverlap(FVector Location, float Radius, TEnumAsByte<ECollisionChannel> TraceChannel = ECC_WorldStatic);
+
+	//Async line trace result of last tick's request.Invalid if there was no request in last tick
+	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "InteractBrush|Trace",meta=(DisplayName="Get Trace Result"))
+	FIWBrushTraceResult GetTraceResult() const;
+
+	//Async overlap result of last tick's request.Return false if there isn't a valid result
+	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "InteractBrush|Trace",meta=(DisplayName="Get Overlap Result"))
+	bool GetOverlapResult(bool& bOverlapping) const;
+
+	//Called by subsystem when async results arrive
+	void SetTraceResult(const FIWBrushTraceResult& Result) {TraceResult = Result;TraceResultFrame = GFrameCounter;}
+	void SetOverlapResult(bool bValid, bool bOverlapping) {bOverlapResultValid = bValid;bOverlapResult = bOverlapping;OverlapResultFrame = GFrameCounter;}
+	
 	//Interact Volume//
 	
 	//These Functions are designed for InteractVolume,when this brush enter an InteractVolume,it will be called
@@ -117,6 +263,22 @@ public:
 	void ResetBrush(){OverlappingInteractVolumes.Empty();UpdateActiveState();}
 	//Get BrushActiveInVolume
 	bool GetBrushActiveInVolume() const {return bBrushActiveInVolume;}
+	bool IsInVolume(const AWorldInteractVolume* InteractVolume) const {return OverlappingInteractVolumes.Contains(InteractVolume);}
+
+	//Activation//
+
+	//Subsystem activates brushes queued in BeginPlay or by RequestRegisterBrush in batches.
+	//Register,bind transform and update volume state
+	void ActivateBrush();
+
+	//Undo ActivateBrush,for EndPlay and RequestUnregisterBrush.Unregister,unbind transform and leave volumes
+	void DeactivateBrush();
+
+	//Does Actor have query collision to 'WorldDynamic',so that InteractVolume can overlap it
+	static bool HasVolumeCollision(const AActor* Actor);
+
+	//Warn that owner has no collision for InteractVolume
+	void AddCollisionWarning() const;
 
 protected:
 	// Called when the game starts
@@ -160,4 +322,36 @@ private:
 
 	//Find DrawingBoards which use InteractVolume that this brush will draw on from InteractVolumes
 	void UpdateDrawOnDrawingBoards();
+
+	//"Draw on RT" is overridden in Blueprint,so it can't draw on worker threads
+	bool bDrawOnRTInBlueprint = true;
+
+	//"Build World Stamps" is overridden in Blueprint,otherwise native version is called without ProcessEvent
+	bool bBuildWorldStampsInBlueprint = true;
+
+	//Async Trace results,only current if delivered in the latest delivery of subsystem
+	FIWBrushTraceResult TraceResult;
+	uint64 TraceResultFrame = MAX_uint64;
+	bool bOverlapResultValid = false;
+	bool bOverlapResult = false;
+	uint64 OverlapResultFrame = MAX_uint64;
+
+	//Result delivered in the latest delivery,not left from an earlier request
+	bool IsTraceResultCurrent(uint64 ResultFrame) const;
+
+	UPROPERTY()
+	UInteractiveWorldSubsystem* InteractiveWorldSubsystem;
+
+	//Waiting in subsystem's dirty list
+	bool bMarkedDirty = false;
+
+	//Mark dirty when moved more than MovementTolerance since last prepared,so still brushes cost nothing each frame
+	void OnBrushTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	//How many times to draw this update,depending on bUseMultiDraw and distance moved
+	int32 GetDrawTimes() const;
+
+	//Stamps cached in WorldStampsFrame
+	TArray<FIWWorldStamp> WorldStamps;
+	uint64 WorldStampsFrame = MAX_uint64;
 };
\ No newline at end of file
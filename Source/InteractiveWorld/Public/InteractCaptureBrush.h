@@ -0,0 +1,56 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InteractBrush.h"
+#include "InteractCaptureBrush.generated.h"
+
+class UMaterialInstanceDynamic;
+class UTextureRenderTarget2D;
+
+//Native brush that stamps the shape of its owner's meshes.
+//Subsystem captures scene depth of its bounds from below with other capture brushes nearby,then it draws the captured depth with BrushMaterial.
+//It draws only when a new capture is done,so it doesn't need bDrawOnMovement
+UCLASS(Blueprintable,ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class INTERACTIVEWORLD_API UInteractCaptureBrush : public UInteractBrush
+{
+	GENERATED_BODY()
+
+public:
+	UInteractCaptureBrush();
+
+	//Material to draw captured depth,it should sample CaptureTextureParameterName.
+	//Depth is distance above bottom of capture bounds,which is CaptureHeight below brush
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|Capture")
+	UMaterialInterface* BrushMaterial;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|Capture")
+	FName CaptureTextureParameterName = FName("CaptureTexture");
+
+	//Capture range below and above brush
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|Capture")
+	float CaptureHeight = 100;
+
+	//World bounds to capture
+	FBox GetCaptureBounds() const;
+
+	//Called by subsystem after capture.CaptureBounds is the whole capture,which may contain other brushes
+	void SetCaptureResult(UTextureRenderTarget2D* CaptureRT, const FBox& CaptureBounds);
+
+	virtual void DrawOnBoardNative(AWorldDrawingBoard* DrawingBoard, float InterpolateRate, int32 DrawTimes) const override;
+	virtual bool HasNativeDraw() const override {return true;}
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UPROPERTY()
+	UMaterialInstanceDynamic* CaptureMaterial;
+
+	//Bounds of this brush when captured,and where it is in capture texture
+	FBox2D CapturedBrushBounds = FBox2D(ForceInit);
+	FVector2D CoordinatePosition = FVector2D::ZeroVector;
+	FVector2D CoordinateSize = FVector2D::UnitVector;
+};
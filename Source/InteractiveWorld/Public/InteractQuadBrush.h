@@ -0,0 +1,34 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InteractBrush.h"
+#include "InteractQuadBrush.generated.h"
+
+//Native brush that draws a quad of Size with BrushMaterial at its location,rotated with its yaw.
+//It doesn't need Blueprint,so its instances can be built on worker threads
+UCLASS(Blueprintable,ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class INTERACTIVEWORLD_API UInteractQuadBrush : public UInteractBrush
+{
+	GENERATED_BODY()
+
+public:
+	UInteractQuadBrush();
+
+	//Material to draw the quad
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|Quad")
+	UMaterialInterface* BrushMaterial;
+
+	//Written into vertex color
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "InteractBrush|Quad")
+	FLinearColor VertexColor = FLinearColor::White;
+
+	virtual void DrawOnBoardNative(AWorldDrawingBoard* DrawingBoard, float InterpolateRate, int32 DrawTimes) const override;
+	virtual bool HasNativeDraw() const override {return true;}
+	virtual void BuildWorldStamps_Implementation(float InterpolateRate, int32 DrawTimes) override;
+
+private:
+	//Quad in world,interpolated from last update for MultiDraw
+	FIWWorldStamp MakeWorldStamp(float InterpolateRate) const;
+};
@@ -0,0 +1,29 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "InteractStampMaterialData.generated.h"
+
+class UMaterialInterface;
+
+//Add to a brush material as Asset User Data to tell DrawingBoards how its stamps blend
+UCLASS(BlueprintType,EditInlineNew,meta = (DisplayName = "Interact Stamp Material Data"))
+class INTERACTIVEWORLD_API UInteractStampMaterialData : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	//Drawing the same stamp again changes the result,like adding fluid force.
+	//Repeated stamps of this material are never elided
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interact Stamp")
+	bool bAccumulative = false;
+
+	//True if Material or one of its parents has data with bAccumulative
+	static bool IsAccumulative(const UMaterialInterface* Material);
+
+	//Add IsAccumulative of Material to Cache if it is not there.Asset user data is only read on game thread,
+	//worker threads look materials up in a Cache filled before them
+	static void CacheIsAccumulative(TMap<const UMaterialInterface*, bool>& Cache, const UMaterialInterface* Material);
+};
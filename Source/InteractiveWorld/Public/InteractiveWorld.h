@@ -3,6 +3,10 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "HAL/LowLevelMemTracker.h"
+
+//All allocations of InteractiveWorld,see "stat LLMFULL" or "iw.MemReport"
+LLM_DECLARE_TAG_API(InteractiveWorld, INTERACTIVEWORLD_API);
 
 class FInteractiveWorldModule : public IModuleInterface
 {
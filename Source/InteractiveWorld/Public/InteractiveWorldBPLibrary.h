@@ -17,6 +17,11 @@ class UInteractiveWorldBPLibrary : public UBlueprintFunctionLibrary
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Resize Rendertarget2D", Keywords = "InteractiveWorld"), Category = "ToolLibrary")
     static void ResizeRenderTarget2D(UTextureRenderTarget2D* RenderTarget2D,int32 SizeX,int32 SizeY);
 
+	//Resize RenderTarget2D and resample its content,so trails are kept
+	//Content is copied to a temporary RenderTarget,then drawn back stretched
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Resize Rendertarget2D Keep Content", Keywords = "InteractiveWorld", WorldContext = "WorldContextObject"), Category = "ToolLibrary")
+	static void ResizeRenderTarget2DKeepContent(UObject* WorldContextObject,UTextureRenderTarget2D* RenderTarget2D,int32 SizeX,int32 SizeY);
+
 	//Convert Vector3 to Vector2.Why there are not a FVector.XY?
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Vector3 to Vector2", Keywords = "vector"), Category = "ToolLibrary")
 	static FVector2D Vector3ToVector2(FVector inVector) {return FVector2D(inVector.X,inVector.Y);}
@@ -5,12 +5,68 @@
 #include "CoreMinimal.h"
 #include "Subsystems/WorldSubsystem.h"
 #include "Engine/World.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include <atomic>
 
 #include "InteractBrush.h"
 #include "WorldDrawingBoard.h"
+#include "CaptureScheduler.h"
+#include "WindFieldSolver.h"
+#include "ViewerSet.h"
+#include "RecyclingQueue.h"
 
 #include "InteractiveWorldSubsystem.generated.h"
 
+//Stamps submitted without InteractBrush,they will be drawn on DrawingBoards of DrawingBoardClass
+struct FIWStampBatch
+{
+	TWeakObjectPtr<UMaterialInterface> Material;
+	//None means all DrawingBoards
+	TSubclassOf<AWorldDrawingBoard> DrawingBoardClass;
+	TArray<FIWStamp> Stamps;
+};
+
+//One stamp pushed from any thread,cheaper than a batch for single impacts
+struct FIWQueuedStamp
+{
+	TWeakObjectPtr<UMaterialInterface> Material;
+	TSubclassOf<AWorldDrawingBoard> DrawingBoardClass;
+	FIWStamp Stamp;
+};
+
+//Register or unregister request pushed from any thread
+struct FIWBrushRegistration
+{
+	TWeakObjectPtr<UInteractBrush> Brush;
+	//Only compared,never dereferenced.Brush destroyed before drain is still removed by it
+	UInteractBrush* BrushKey = nullptr;
+	bool bRegister = true;
+};
+
+class UInteractCaptureBrush;
+class USceneCaptureComponent2D;
+
+class UMaterialParameterCollection;
+
+//A parameter of MaterialParameterCollection written through subsystem.Value is pushed only when it differs from PushedValue
+struct FIWCollectionParameter
+{
+	TWeakObjectPtr<UMaterialParameterCollection> Collection;
+	FName Name;
+	bool bScalar = false;
+	FLinearColor Value = FLinearColor::Black;
+	FLinearColor PushedValue = FLinearColor::Black;
+	bool bPushed = false;
+	bool bPending = false;
+};
+
+//Async trace or overlap requested by a brush,waiting for result
+struct FIWPendingBrushTrace
+{
+	TWeakObjectPtr<UInteractBrush> Brush;
+	FTraceHandle Handle;
+	bool bOverlap = false;
+};
 
 UCLASS()
 class INTERACTIVEWORLD_API UInteractiveWorldSubsystem : public UWorldSubsystem,public FTickableGameObject
@@ -32,6 +88,23 @@ public:
 	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Register",meta=(DisplayName="Unregister Brush"))
 	void UnregisterBrush(UInteractBrush* Brush);
 
+	//Brush begins play,it will be activated in a batch within MaxBrushActivationsPerFrame
+	void QueueBrushActivation(UInteractBrush* Brush);
+
+	//Brushes activated in one tick,others wait for next ticks.If less than or equal to 0,activate all in next tick
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Register")
+	int32 MaxBrushActivationsPerFrame = 32;
+
+	//InteractVolumes register themselves,so brushes can find volumes without world queries
+	void RegisterInteractVolume(AWorldInteractVolume* InteractVolume);
+	void UnregisterInteractVolume(AWorldInteractVolume* InteractVolume);
+
+	//Brush moved or asked to draw,it will be prepared in next tick
+	void MarkBrushDirty(UInteractBrush* Brush);
+
+	//Brush's bDrawEveryFrame changed
+	void UpdateEveryFrameBrush(UInteractBrush* Brush);
+
 	//Register a DrawingBoard to subsystem,then the brush can be allocated to it and draw trails
 	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Register",meta=(DisplayName="Register Drawing Board"))
 	void RegisterDrawingBoard(AWorldDrawingBoard* DrawingBoard);
@@ -40,31 +113,367 @@ public:
 	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Register",meta=(DisplayName="Unregister Drawing Board"))
 	void UnregisterDrawingBoard(AWorldDrawingBoard* DrawingBoard);
 
-	//Distance from player camera,brushes out of range will not be drawn.If less than 0,will not cull brushes.
+	//Submit stamps without InteractBrush,they will be batched and drawn in next tick.
+	//This is thread safe and lock free,so Niagara,physics callbacks and worker threads can call it.
+	void SubmitStamps(UMaterialInterface* Material, TSubclassOf<AWorldDrawingBoard> DrawingBoardClass, TArray<FIWStamp>&& Stamps);
+
+	//Get a recycled batch with empty Stamps,fill it in place and queue it with SubmitStampBatch.
+	//Its array keeps memory of former use,so steady state doesn't allocate.Thread safe and lock free
+	FIWStampBatch* AllocateStampBatch(UMaterialInterface* Material, TSubclassOf<AWorldDrawingBoard> DrawingBoardClass);
+	void SubmitStampBatch(FIWStampBatch* Batch);
+
+	//Submit one stamp,like an impact from physics thread.Thread safe and lock free
+	void SubmitStamp(UMaterialInterface* Material, TSubclassOf<AWorldDrawingBoard> DrawingBoardClass, const FIWStamp& Stamp);
+
+	//Register or unregister brush in next tick.Thread safe and lock free
+	void RequestRegisterBrush(UInteractBrush* Brush);
+	void RequestUnregisterBrush(UInteractBrush* Brush);
+
+	//Add stamps without InteractBrush,they will be drawn on DrawingBoards of DrawingBoardClass in next tick.
+	//If DrawingBoardClass is None,they will be drawn on all DrawingBoards
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Stamp",meta=(DisplayName="Add Stamps"))
+	void AddStamps(UMaterialInterface* Material, TSubclassOf<AWorldDrawingBoard> DrawingBoardClass, const TArray<FIWStamp>& Stamps);
+
+	//Distance from viewers,brushes out of range of all viewers will not be drawn.If less than 0,will not cull brushes.
+	//Viewers are cameras of local players,view targets of remote players on server,and registered viewers
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Culling")
 	float BrushCullDistance = -1;
 
+	//Brushes around Viewer will be drawn,like a cinematic camera or an AI that should leave trails.Brushes are culled as if it's a player
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Culling",meta=(DisplayName="Register Viewer"))
+	void RegisterViewer(AActor* Viewer);
+
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Culling",meta=(DisplayName="Unregister Viewer"))
+	void UnregisterViewer(AActor* Viewer);
+
+	//Build instances of native brushes on worker threads,one task for each DrawingBoard
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Performance")
+	bool bParallelBuildInstances = true;
+
+	//Viewers that brushes are culled around in this tick,for drawing without InteractBrush.
+	//Return false if brushes are not culled
+	bool GetBrushCullViewers(const FIWViewerSet*& OutViewers) const;
+
+	//Async Trace//
+
+	//Start an async line trace for brush,result will be given to brush in next tick before brushes are prepared
+	void RequestTrace(UInteractBrush* Brush, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel);
+
+	//Start an async sphere overlap for brush,result will be given to brush in next tick before brushes are prepared
+	void RequestOverlap(UInteractBrush* Brush, const FVector& Location, float Radius, ECollisionChannel TraceChannel);
+
+	//Frame of the last time results were given to brushes,results of earlier frames are stale
+	uint64 GetTraceDeliveryFrame() const {return TraceDeliveryFrame;}
+
+	//Scene Capture//
+
+	//Capture brushes are captured by subsystem's shared scene captures
+	void RegisterCaptureBrush(UInteractCaptureBrush* Brush);
+	void UnregisterCaptureBrush(UInteractCaptureBrush* Brush);
+
+	//Scene captures in one frame,capture brushes over budget wait for next frames
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Capture")
+	int32 MaxCapturesPerFrame = 2;
+
+	//Resolution of each scene capture
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Capture")
+	int32 CaptureResolution = 256;
+
+	//Max world size of one capture,capture brushes closer than CaptureMergeDistance are captured together within this size
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Capture")
+	float MaxCaptureSize = 1000;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Capture")
+	float CaptureMergeDistance = 50;
+
+	//Each this distance from camera adds one frame between captures of a brush.If less than or equal to 0,capture every frame
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Capture")
+	float CaptureIntervalDistance = 2000;
+
+	//Max frames between captures of a moving brush
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Capture")
+	int32 MaxCaptureInterval = 8;
+
+	//CPU Wind//
+
+	//Run a low resolution wind field on CPU,so gameplay can read wind without GPU readback.It also runs on server
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	bool bEnableCPUWind = false;
+
+	//Cells in each side of wind field
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	int32 WindGridSize = 64;
+
+	//World size of each cell
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	float WindCellSize = 200;
+
+	//Fixed time step,so server and clients get the same wind for the same forces
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	float WindTimeStep = 1.f / 30.f;
+
+	//Velocity lost each second
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	float WindDissipation = 0.5f;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	int32 WindPressureIterations = 20;
+
+	//Wind field follows player camera if there is one.Otherwise use "Set Wind Field Center"
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | CPU Wind")
+	bool bWindFollowCamera = true;
+
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | CPU Wind",meta=(DisplayName="Set Wind Field Center"))
+	void SetWindFieldCenter(FVector Center);
+
+	//Pull wind in Radius toward Velocity,for affectors.Applied in next wind step
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | CPU Wind",meta=(DisplayName="Add Wind Force"))
+	void AddWindForce(FVector Location, FVector Velocity, float Radius);
+
+	//Wind velocity at Location,zero outside wind field
+	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "Interactive World Subsystem | CPU Wind",meta=(DisplayName="Get Wind Velocity"))
+	FVector GetWindVelocity(FVector Location) const;
+
+	//Sample many locations in one call
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | CPU Wind",meta=(DisplayName="Sample Wind Velocity"))
+	void SampleWindVelocity(const TArray<FVector>& Locations, TArray<FVector>& OutVelocities) const;
+
+	const FIWWindFieldSolver& GetWindFieldSolver() const {return WindFieldSolver;}
+
+	//Scalability//
+
+	//RT scale of DrawingBoards with bFollowScalability for each effects quality level,Low to Cinematic.Multiplied by "iw.RTScale"
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Scalability")
+	TArray<float> RTScalePerQualityLevel = {0.5f, 0.75f, 1.f, 1.f, 1.f};
+
+	//MultiDraw density of brushes for each effects quality level,Low to Cinematic.Multiplied by "iw.MultiDrawDensity"
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Scalability")
+	TArray<float> MultiDrawDensityPerQualityLevel = {0.25f, 0.5f, 1.f, 1.f, 1.f};
+
+	//Effects quality level,lowered by governor when "iw.Governor" is on and tick costs more than "iw.GovernorBudgetMs"
+	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "Interactive World Subsystem | Scalability",meta=(DisplayName="Get Quality Level"))
+	int32 GetQualityLevel() const;
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "Interactive World Subsystem | Scalability",meta=(DisplayName="Get RT Scale"))
+	float GetRTScale() const {return RTScale;}
+
+	//Brushes with MultiDraw draw this times as often
+	UFUNCTION(BlueprintCallable,BlueprintPure,Category = "Interactive World Subsystem | Scalability",meta=(DisplayName="Get MultiDraw Density"))
+	float GetMultiDrawDensity() const {return MultiDrawDensity;}
+
+	//Smoothed game thread cost of subsystem tick,including DrawingBoards simulating
+	float GetSmoothedTickMs() const {return SmoothedTickMs;}
+
+	//Material Parameters//
+
+	//Set a scalar parameter of ParameterCollection.It's pushed in next flush,only if it differs from value pushed last time
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Material Parameters",meta=(DisplayName="Set Collection Scalar Parameter"))
+	void SetCollectionScalarParameter(UMaterialParameterCollection* Collection, FName ParameterName, float Value);
+
+	//Set a vector parameter of ParameterCollection.It's pushed in next flush,only if it differs from value pushed last time
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Material Parameters",meta=(DisplayName="Set Collection Vector Parameter"))
+	void SetCollectionVectorParameter(UMaterialParameterCollection* Collection, FName ParameterName, FLinearColor Value);
+
+	//Push changed parameters to collection instances.Called at the end of every tick,and by DrawingBoards before simulation steps that read them
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Material Parameters",meta=(DisplayName="Flush Collection Parameters"))
+	void FlushCollectionParameters();
+
+	//Render Target Pool//
+
+	//Get a RenderTarget from pool,or create a new one if there is no suitable one.It will be cleared to ClearColor
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Render Target Pool",meta=(DisplayName="Acquire Render Target"))
+	UTextureRenderTarget2D* AcquireRenderTarget(int32 SizeX, int32 SizeY, ETextureRenderTargetFormat Format, FLinearColor ClearColor);
+
+	//Return a RenderTarget to pool.If pool is full,it is dropped and freed by GC when nothing references it
+	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Render Target Pool",meta=(DisplayName="Release Render Target"))
+	void ReleaseRenderTarget(UTextureRenderTarget2D* RenderTarget);
+
+	//Max idle RenderTargets kept in pool
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Interactive World Subsystem | Render Target Pool")
+	int32 MaxPooledRenderTargets = 2;
+
 	//For Debugging
 	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Debug",meta=(DisplayName="Get Registered Drawing Boards"))
 	TArray<AWorldDrawingBoard*> GetRegisteredDrawingBoards(){return DrawingBoards;}
 
 	UFUNCTION(BlueprintCallable,Category = "Interactive World Subsystem | Debug",meta=(DisplayName="Get Registered Interact Brushes"))
 	TArray<UInteractBrush*> GetRegisteredInteractBrushes(){return Brushes;}
+
+	//Print memory of DrawingBoards,brushes and registries,for "iw.MemReport"
+	void DumpMemoryReport(FOutputDevice& Ar) const;
 	
 private:
 	//Brushes that registered
 	UPROPERTY()
 	TArray<UInteractBrush*> Brushes;
 
+	//Brushes began play,waiting for activation
+	UPROPERTY()
+	TArray<UInteractBrush*> PendingActivationBrushes;
+
+	//InteractVolumes that registered
+	UPROPERTY()
+	TArray<AWorldInteractVolume*> InteractVolumes;
+
+	//If owner actor class has collision for InteractVolume,checked once for each class
+	TMap<TWeakObjectPtr<UClass>, bool> OwnerClassHasVolumeCollision;
+
+	//Activate queued brushes within budget,then let volumes find them with one pass for the batch
+	void ActivatePendingBrushes();
+
+	//Activated brushes inside one InteractVolume,kept between frames so steady state doesn't allocate
+	TArray<UInteractBrush*> BrushesInVolume;
+
+	//Result of overlap query of one InteractVolume,kept between frames so steady state doesn't allocate
+	TArray<FOverlapResult> VolumeOverlaps;
+
+	//Brushes that draw every frame,prepared in every tick
+	UPROPERTY()
+	TArray<UInteractBrush*> EveryFrameBrushes;
+
+	//Brushes that moved or called DrawBrush since last tick
+	UPROPERTY()
+	TArray<UInteractBrush*> DirtyBrushes;
+
+	//Brushes that were dirty in last tick,prepare once more so they settle at the new transform
+	UPROPERTY()
+	TArray<UInteractBrush*> SettlingBrushes;
+
+	//Brushes to prepare in this tick,kept to reuse memory
+	TArray<UInteractBrush*> BrushesToPrepare;
+
+	//Brushes that will draw in this tick,kept to reuse memory
+	TArray<UInteractBrush*> BrushesNeedDrawing;
+
+	//Classes of DrawingBoards that do not use InteractVolumes in this tick,kept to reuse memory
+	TArray<TSubclassOf<AWorldDrawingBoard>> NoVolumeDrawingBoardClasses;
+
 	//DrawingBoards that registered
 	UPROPERTY()
 	TArray<AWorldDrawingBoard*> DrawingBoards;
 
-	//Prepare InteractBrushes.This will cull invalid and far InteractBrushes
-	bool PrepareBrushes(TArray<UInteractBrush*>& BrushesNeedDrawing);
+	//Idle RenderTargets that can be acquired
+	UPROPERTY()
+	TArray<UTextureRenderTarget2D*> PooledRenderTargets;
+
+	//DrawingBoards allocated in this tick
+	UPROPERTY()
+	TArray<AWorldDrawingBoard*> AllocatedDrawingBoards;
+
+	//Brushes allocated for each of AllocatedDrawingBoards,same order.Kept between ticks to reuse memory
+	TArray<TArray<UInteractBrush*>> AllocatedBrushes;
+
+	//Whether materials drawn in this tick are accumulative,filled on game thread for BuildParallelInstances.
+	//Refilled every tick so edited material data is picked up,kept to reuse memory
+	TMap<const UMaterialInterface*, bool> AccumulativeMaterials;
+
+	//Stamps submitted from any thread,waiting for next tick
+	TIWRecyclingQueue<FIWStampBatch> QueuedStampBatches;
+	TIWRecyclingQueue<FIWQueuedStamp> QueuedStamps;
+	//For debugging,stamps pushed since last drain
+	std::atomic<int32> NumQueuedStamps{0};
+
+	//Brush registrations requested from any thread
+	TIWRecyclingQueue<FIWBrushRegistration> QueuedBrushRegistrations;
+
+	//Register and unregister requested brushes
+	void DrainBrushRegistrations();
+
+	//Remove a destroyed brush from registries without touching it,and entries GC cleared
+	void RemoveDestroyedBrush(UInteractBrush* BrushKey);
+
+	//Stamps drained from queues,merged by material and DrawingBoard class,drawing in this tick
+	TArray<FIWStampBatch> DrawingStampBatches;
+
+	//Find or add batch of material and DrawingBoard class in DrawingStampBatches
+	FIWStampBatch& FindOrAddDrawingStampBatch(const TWeakObjectPtr<UMaterialInterface>& Material, TSubclassOf<AWorldDrawingBoard> DrawingBoardClass);
+
+	//Drain stamp queues to DrawingStampBatches,return if there are any stamp
+	bool TakePendingStamps();
+
+	//Add stamps of DrawingStampBatches to DrawingBoard as instances
+	void AllocateStamps(AWorldDrawingBoard* DrawingBoard);
+
+	//Traces requested in last tick,and traces requested in this tick
+	TArray<FIWPendingBrushTrace> PendingTraces;
+	TArray<FIWPendingBrushTrace> RequestedTraces;
+
+	//Give results of last tick's traces to brushes
+	void DeliverTraceResults();
+	uint64 TraceDeliveryFrame = 0;
+
+	FIWWindFieldSolver WindFieldSolver;
+
+	//Brushes with bAffectCPUWind,and their locations in last tick
+	UPROPERTY()
+	TArray<UInteractBrush*> WindBrushes;
+	TArray<FVector> WindBrushLocations;
+
+	//Add forces of moving wind brushes and step wind field
+	void UpdateWind(float DeltaTime);
+
+	//Wind field dropped time in last update,warn only when it starts
+	bool bWindDroppingTime = false;
+
+	//Capture brushes that registered
+	UPROPERTY()
+	TArray<UInteractCaptureBrush*> CaptureBrushes;
+
+	//Shared scene captures,one for each capture in a frame
+	UPROPERTY()
+	TArray<USceneCaptureComponent2D*> CaptureComponents;
+
+	FIWCaptureScheduler CaptureScheduler;
+
+	//Kept between ticks to reuse memory
+	TArray<FIWCaptureRequest> CaptureRequests;
+	TArray<FIWCaptureJob> CaptureJobs;
+
+	//Schedule and capture capture brushes,then they will draw in this tick
+	void UpdateCaptures();
+
+	//Get or create shared scene capture
+	USceneCaptureComponent2D* GetCaptureComponent(int32 Index);
+
+	//Parameters written through SetCollection*Parameter,and index of each collection and name
+	TArray<FIWCollectionParameter> CollectionParameters;
+	TMap<TPair<const UMaterialParameterCollection*, FName>, int32> CollectionParameterIndices;
+	//Indices of CollectionParameters set since last flush
+	TArray<int32> PendingCollectionParameters;
+
+	//Find or add parameter,and queue it if its value changed
+	void SetCollectionParameter(UMaterialParameterCollection* Collection, FName ParameterName, bool bScalar, const FLinearColor& Value);
+
+	//Viewers of this tick
+	FIWViewerSet ViewerSet;
+
+	//Registered by "Register Viewer"
+	TArray<TWeakObjectPtr<AActor>> CustomViewers;
+
+	//Collect viewers of local players,remote players and custom viewers
+	void UpdateViewers();
+
+	//Scales of this tick
+	float RTScale = 1;
+	float MultiDrawDensity = 1;
+
+	//Quality levels lowered by governor
+	int32 GovernorSteps = 0;
+	float SmoothedTickMs = 0;
+	float GovernorCooldown = 0;
+
+	//Update scales from quality level and console variables
+	void UpdateScalability();
+
+	//Lower or raise quality by measured tick cost
+	void UpdateGovernor(float DeltaTime, float TickMs);
+
+	//Prepare dirty and every frame InteractBrushes.This will cull invalid and far InteractBrushes
+	bool PrepareBrushes(TArray<UInteractBrush*>& OutBrushesNeedDrawing);
 
 	//Allocate InteractBrushes for DrawingBoards
 	void AllocateBrushes();
 
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
 };
\ No newline at end of file
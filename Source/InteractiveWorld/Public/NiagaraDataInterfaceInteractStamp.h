@@ -0,0 +1,64 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "WorldDrawingBoard.h"
+#include "NiagaraDataInterfaceInteractStamp.generated.h"
+
+class UInteractiveWorldSubsystem;
+
+//Stamps written by particles of one system instance in this frame
+struct FNDIInteractStampInstanceData
+{
+	TWeakObjectPtr<UInteractiveWorldSubsystem> Subsystem;
+
+	//VM may run chunks of particles on different worker threads
+	FCriticalSection StampsLock;
+	TArray<FIWStamp> Stamps;
+};
+
+//Let CPU particles draw stamps on DrawingBoards without InteractBrush.
+//Stamps of each frame are submitted to subsystem,and drawn as one batch for each DrawingBoard.
+UCLASS(EditInlineNew, Category = "Interactive World", meta = (DisplayName = "Interactive World Stamp"))
+class INTERACTIVEWORLD_API UNiagaraDataInterfaceInteractStamp : public UNiagaraDataInterface
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	//Material to draw stamps.Stamp intensity will be written into vertex color
+	UPROPERTY(EditAnywhere, Category = "Interactive World Stamp")
+	UMaterialInterface* StampMaterial;
+
+	//Only draw on this class of DrawingBoards.None means all DrawingBoards
+	UPROPERTY(EditAnywhere, Category = "Interactive World Stamp")
+	TSubclassOf<AWorldDrawingBoard> DrawingBoardClass;
+
+	//Max stamps of each system instance in one frame,others will fail.If less than 0,no limit
+	UPROPERTY(EditAnywhere, Category = "Interactive World Stamp")
+	int32 MaxStampsPerFrame = 4096;
+
+	//UObject Interface
+	virtual void PostInitProperties() override;
+	//UObject Interface End
+
+	//UNiagaraDataInterface Interface
+	virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc) override;
+	virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual int32 PerInstanceDataSize() const override { return sizeof(FNDIInteractStampInstanceData); }
+	virtual bool HasPostSimulateTick() const override { return true; }
+	virtual bool PerInstanceTickPostSimulate(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return Target == ENiagaraSimTarget::CPUSim; }
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+	//UNiagaraDataInterface Interface End
+
+protected:
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+
+private:
+	//Add a stamp for each executing particle
+	void VMAddStamp(FVectorVMExternalFunctionContext& Context);
+};
@@ -0,0 +1,67 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LockFreeList.h"
+
+//Lock free multi producer single consumer queue.TQueue allocates a node for every Enqueue,
+//this one takes drained items back and reuses them,so it doesn't allocate once warmed up.
+//AllocateItem and Push can be called from any thread,Drain only from the consumer thread
+template <typename ItemType>
+class TIWRecyclingQueue
+{
+public:
+	TIWRecyclingQueue() = default;
+	TIWRecyclingQueue(const TIWRecyclingQueue&) = delete;
+	TIWRecyclingQueue& operator=(const TIWRecyclingQueue&) = delete;
+
+	~TIWRecyclingQueue()
+	{
+		Empty();
+	}
+
+	//Get an item to fill and Push,it may hold values of an old item so set every member
+	ItemType* AllocateItem()
+	{
+		ItemType* Item = FreeItems.Pop();
+		return Item ? Item : new ItemType();
+	}
+
+	void Push(ItemType* Item)
+	{
+		QueuedItems.Push(Item);
+	}
+
+	//Call Func on queued items in push order,then take them back for reuse
+	template <typename FuncType>
+	void Drain(FuncType&& Func)
+	{
+		QueuedItems.PopAll(DrainingItems);
+		for (ItemType* Item : DrainingItems)
+		{
+			Func(*Item);
+			FreeItems.Push(Item);
+		}
+		DrainingItems.Reset();
+	}
+
+	//Drop queued items and free all memory,no producer may push meanwhile
+	void Empty()
+	{
+		Drain([](ItemType&)
+		{
+		});
+		while (ItemType* Item = FreeItems.Pop())
+		{
+			delete Item;
+		}
+		DrainingItems.Empty();
+	}
+
+private:
+	TLockFreePointerListFIFO<ItemType, PLATFORM_CACHE_LINE_SIZE> QueuedItems;
+	TLockFreePointerListUnordered<ItemType, PLATFORM_CACHE_LINE_SIZE> FreeItems;
+	//Consumer only,kept between drains so steady state doesn't allocate
+	TArray<ItemType*> DrainingItems;
+};
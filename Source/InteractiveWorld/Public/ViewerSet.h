@@ -0,0 +1,41 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Locations that brushes are culled around,like local players,view targets of remote players and custom viewers.
+//A brush is relevant if it is in range of any viewer.With many viewers,a grid is used so queries only visit nearby ones
+struct INTERACTIVEWORLD_API FIWViewerSet
+{
+	//Clear viewers,and set distance around each viewer
+	void Reset(float InCullDistance);
+
+	void AddViewer(const FVector& Location);
+
+	//Build grid after all viewers are added
+	void Build();
+
+	//If a sphere of Radius at Location is in range of any viewer,only XY is used
+	bool IsInRange(const FVector& Location, float Radius) const;
+
+	//Distance in XY to the nearest viewer,max float if there is no viewer
+	float GetNearestDistance(const FVector& Location) const;
+
+	int32 Num() const {return Viewers.Num();}
+
+	const TArray<FVector>& GetViewers() const {return Viewers;}
+
+	float GetCullDistance() const {return CullDistance;}
+
+private:
+	float CullDistance = 0;
+	float CellSize = 1;
+	TArray<FVector> Viewers;
+
+	//Viewer indices of each cell,only built when there are more viewers than a linear search handles well
+	TMap<FIntPoint, TArray<int32, TInlineAllocator<4>>> Cells;
+	bool bUseCells = false;
+
+	FIntPoint GetCell(double X, double Y) const;
+};
@@ -0,0 +1,97 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Low resolution stable fluids solver for wind on CPU,so gameplay can read wind without GPU readback.
+//It steps with fixed time step and gives the same result for the same forces,so it can run on server.
+//This is a plain struct without UObject or RHI,so it can be tested without GPU.
+struct INTERACTIVEWORLD_API FIWWindFieldSolver
+{
+	//Fixed time step of simulation
+	float TimeStep = 1.f / 30.f;
+
+	//Max steps in one Update.Time over that is caught up in next Updates,up to the same number of steps,the rest is dropped
+	int32 MaxStepsPerUpdate = 4;
+
+	//Jacobi iterations to solve pressure
+	int32 PressureIterations = 20;
+
+	//Velocity lost each second
+	float Dissipation = 0.5f;
+
+	//Allocate a square grid of GridSize cells,each is CellSize in world.Clear wind
+	void Initialize(int32 InGridSize, float InCellSize);
+
+	bool IsInitialized() const {return GridSize > 0;}
+
+	//Move grid to center at WorldCenter,snapped to cells.Wind moves with world,new cells are still
+	void SetCenter(const FVector2D& WorldCenter);
+
+	//Wind in Radius will be pulled toward Velocity in every step of next Update that runs steps.
+	//Forces added again before that are merged instead of stacked,so result doesn't depend on frame rate.Not thread safe
+	void AddForce(const FVector2D& Location, const FVector2D& Velocity, float Radius);
+
+	//Run fixed steps for DeltaTime,return how many steps ran.Forces are cleared if any step ran
+	int32 Update(float DeltaTime);
+
+	//Run one fixed step with current forces,forces are kept
+	void Step();
+
+	//Drop forces added since last Update that ran steps
+	void ClearForces();
+
+	//Total simulation time dropped because Update couldn't catch up within MaxStepsPerUpdate
+	float GetDroppedTime() const {return DroppedTime;}
+
+	//Wind velocity at world location,zero outside grid
+	FVector2D SampleVelocity(const FVector2D& Location) const;
+
+	//Batched SampleVelocity,OutVelocities should be as long as Locations
+	void SampleVelocities(TArrayView<const FVector2D> Locations, TArrayView<FVector2D> OutVelocities) const;
+
+	int32 GetGridSize() const {return GridSize;}
+	float GetCellSize() const {return CellSize;}
+
+	//World location of grid min corner
+	FVector2D GetOrigin() const {return FVector2D(OriginCell) * CellSize;}
+
+	//Bytes of grid buffers and pending forces
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	int32 GridSize = 0;
+	float CellSize = 100;
+	FIntPoint OriginCell = FIntPoint::ZeroValue;
+	float TimeAccumulator = 0;
+	float DroppedTime = 0;
+
+	//Forces rasterized to grid.Velocity weighted by force weight,sum of weights,and the strongest weight which is how much to pull
+	TArray<float> ForceX;
+	TArray<float> ForceY;
+	TArray<float> ForceWeightSum;
+	TArray<float> ForceWeight;
+	bool bHasForces = false;
+
+	//Row major,world units per second
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> Pressure;
+	TArray<float> Divergence;
+	//Scratch buffers of the same size
+	TArray<float> TempX;
+	TArray<float> TempY;
+
+	int32 GetIndex(int32 X, int32 Y) const {return Y * GridSize + X;}
+
+	//Bilinear sample at grid position,clamped to edge
+	float SampleField(const TArray<float>& Field, float GridX, float GridY) const;
+
+	void ApplyForces();
+	void Advect(float DeltaTime);
+	void Project();
+
+	//Grid moved by Offset cells
+	void Shift(const FIntPoint& Offset);
+};
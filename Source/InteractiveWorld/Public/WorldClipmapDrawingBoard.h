@@ -0,0 +1,75 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldDrawingBoard.h"
+#include "WorldClipmapDrawingBoard.generated.h"
+
+//DrawingBoard with nested levels around the same center.Level 0 is RTDrawOn,each next level covers double canvas size with the same RT size.
+//InteractBrushes are allocated and drawn once,instances added by "Add Brush Instance" are copied to every level where they are at least one pixel.
+//Brushes drawing on canvas directly will only draw on level 0.Coarser levels are shifted natively when canvas moves.
+//Wrap around canvas is not supported,it is turned off with a warning.
+UCLASS()
+class INTERACTIVEWORLD_API AWorldClipmapDrawingBoard : public AWorldDrawingBoard
+{
+	GENERATED_BODY()
+
+public:
+	AWorldClipmapDrawingBoard();
+
+protected:
+	virtual void BeginPlay() override;
+
+	//How many levels,including level 0
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "World Drawing Board | Clipmap",meta = (ClampMin = 1,ClampMax = 8))
+	int32 NumLevels = 4;
+
+	//RenderTargets of each level.Level 0 is always RTDrawOn,others will be created with the same size and format if not set
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "World Drawing Board | Clipmap")
+	TArray<UTextureRenderTarget2D*> LevelRenderTargets;
+
+	//Make sure there are RenderTargets for every level
+	void UpdateLevelRenderTargets(UTextureRenderTarget2D* RTDrawOn);
+
+	virtual void OnRenderTargetsAcquired_Implementation() override;
+
+	//Shift coarser levels with canvas,level 0 is shifted by simulation passes
+	virtual void OnCanvasMoved() override;
+
+	//Content of a level is drawn here shifted,then copied back,so a RenderTarget isn't read and written in one pass
+	UPROPERTY()
+	UTextureRenderTarget2D* LevelShiftRT;
+
+	//Sub pixel canvas movement of each level not shifted yet,so slow movement still shifts coarse levels
+	TArray<FVector2D> LevelShiftRemainders;
+
+	//Draw instances of level 0 on a coarser level
+	void DrawInstancesOnLevel(const TMap<UMaterialInterface*,FIWTriangleList>& Instances, int32 Level);
+
+	//Triangles transformed to a level,kept between frames so drawing levels doesn't allocate
+	TArray<FCanvasUVTri> LevelTriangles;
+
+public:
+	virtual void DrawBrushes(const TArray<UInteractBrush*>& Brushes,UTextureRenderTarget2D* RTDrawOn) override;
+
+	//Cull with the coarsest level
+	virtual float GetNearestDistance(FVector2D WorldLocation) const override;
+
+	virtual void GetRenderTargets(TArray<UTextureRenderTarget2D*>& OutRenderTargets) const override;
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Num Levels"), Category="World Drawing Board | Clipmap")
+	int32 GetNumLevels() const {return NumLevels;}
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Level RenderTarget"), Category="World Drawing Board | Clipmap")
+	UTextureRenderTarget2D* GetLevelRenderTarget(int32 Level) const {return LevelRenderTargets.IsValidIndex(Level) ? LevelRenderTargets[Level] : nullptr;}
+
+	//Canvas size and pixel size of a level,for sampling materials
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Level Parameters"), Category="World Drawing Board | Clipmap")
+	void GetLevelParameters(int32 Level, FVector2D& OutCanvasWorldSize, FVector2D& OutPixelWorldSize) const;
+
+	//The finest level that covers WorldLocation with Margin(in pixels) to its edge,-1 if no level covers it.
+	//This is what sampling materials do on GPU
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Finest Level At"), Category="World Drawing Board | Clipmap")
+	int32 GetFinestLevelAt(FVector2D WorldLocation, float Margin = 1) const;
+};
@@ -4,9 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "InteractBrush.h"
+#include "DirtyRegionTracker.h"
 #include "GameFramework/Actor.h"
+#include "Engine/TextureRenderTarget2D.h"
 #include "Materials/MaterialInterface.h"
+#include "UObject/ObjectKey.h"
 #include "WorldDrawingBoard.generated.h"
+
+class UMaterialParameterCollection;
+class UMaterialInstanceDynamic;
+class UInteractBakedLayer;
+class FIWContentReadback;
+struct FStreamableHandle;
+
 USTRUCT()
 
 struct FIWTriangleList
@@ -15,6 +25,143 @@ struct FIWTriangleList
 	TArray<FCanvasUVTri> Triangles;
 };
 
+//A stamp in world space.It can be drawn without InteractBrush,like particles
+USTRUCT(BlueprintType)
+struct FIWStamp
+{
+	GENERATED_BODY()
+
+	//Stamp center in world
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FVector2D Location = FVector2D::ZeroVector;
+
+	//Stamp size in world
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	FVector2D Size = FVector2D(10,10);
+
+	//Stamp yaw in world
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	float Rotation = 0;
+
+	//Will be written into vertex color,material can use it to scale drawing
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Stamp")
+	float Intensity = 1;
+};
+
+//One quad in canvas space,same parameters as AddBrushInstance
+USTRUCT(BlueprintType)
+struct FIWBrushInstance
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	FVector2D ScreenPosition = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	FVector2D ScreenSize = FVector2D::UnitVector;
+
+	//Degrees,rotate around PivotPoint
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	float Rotation = 0;
+
+	//Relative to quad,(0.5,0.5) is center
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	FVector2D PivotPoint = FVector2D(0.5f,0.5f);
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	FVector2D CoordinatePosition = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	FVector2D CoordinateSize = FVector2D::UnitVector;
+
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "Brush Instance")
+	FLinearColor VertexColor = FLinearColor::White;
+};
+
+//A RenderTarget that DrawingBoard acquires from subsystem's pool when it starts simulating,and returns after sleeping for a while
+USTRUCT(BlueprintType)
+struct FIWPooledRenderTargetSlot
+{
+	GENERATED_BODY()
+
+	//Name to find this RenderTarget
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Pooled Render Target")
+	FName Name;
+
+	//Size is RTSize of DrawingBoard
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Pooled Render Target")
+	TEnumAsByte<ETextureRenderTargetFormat> Format = RTF_RGBA16f;
+
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Pooled Render Target")
+	FLinearColor ClearColor = FLinearColor::Black;
+
+	//Set as RTDrawOn when acquired
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Pooled Render Target")
+	bool bDrawOn = false;
+
+	//Keep a compressed CPU copy of content when released,and restore it when acquired again.
+	//Content is read back without stalling,but the RenderTarget stays out of pool until it's saved.
+	//Costs CPU memory,so only enable for content that must survive sleeping
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Pooled Render Target")
+	bool bKeepContent = false;
+};
+
+//A ring of pooled RenderTargets for simulations that read former frames,like water heights of last two frames.
+//Advancing rotates buffers instead of copying content to the previous buffer
+USTRUCT(BlueprintType)
+struct FIWRenderTargetRing
+{
+	GENERATED_BODY()
+
+	//Name to find this ring
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring")
+	FName Name;
+
+	//Buffers in ring,including current one
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring",meta = (ClampMin = 2,ClampMax = 8))
+	int32 NumBuffers = 2;
+
+	//Size is RTSize of DrawingBoard
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring")
+	TEnumAsByte<ETextureRenderTargetFormat> Format = RTF_RGBA16f;
+
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring")
+	FLinearColor ClearColor = FLinearColor::Black;
+
+	//Current buffer is RTDrawOn
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring")
+	bool bDrawOn = false;
+
+	//Rotate at the end of every simulation step,after "Post Simulate".Otherwise call "Advance Render Target Ring".
+	//Simulation reads current buffer with stamps of this step and writes the oldest one(Age NumBuffers-1),which becomes current
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring")
+	bool bAdvanceEachStep = true;
+
+	//Texture parameters set on registered materials.Index 0 is current buffer,1 is previous buffer and so on.None to skip
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "Render Target Ring")
+	TArray<FName> TextureParameterNames;
+};
+
+//Memory used by a DrawingBoard,for "iw.MemReport"
+struct FIWDrawingBoardMemoryStats
+{
+	int32 NumRenderTargets = 0;
+	int64 RenderTargetBytes = 0;
+	//Triangle lists waiting for DispatchDrawInstances,including reserved memory
+	int64 InstanceBufferBytes = 0;
+	int32 PendingTriangles = 0;
+	//Most triangles drawn in one DispatchDrawInstances
+	int32 PeakTriangles = 0;
+	//Compressed content of released pooled RenderTargets,and the texture it is restored through
+	int64 SavedContentBytes = 0;
+	int32 NumBakedTiles = 0;
+	int64 BakedTileBytes = 0;
+	int32 NumDirtyRects = 0;
+	bool bSimulating = false;
+	bool bRenderTargetsAcquired = false;
+	float TimeFromLastDraw = 0;
+};
+
 UCLASS()
 class INTERACTIVEWORLD_API AWorldDrawingBoard : public AActor
 {
@@ -25,10 +172,6 @@ public:
 	AWorldDrawingBoard();
 
 private:
-	//This map stores triangles that desired to draw as instances
-	UPROPERTY()
-	TMap<UMaterialInterface*,FIWTriangleList> TriangleInstancesMap;
-	
 	//InteractVolumes that make this DrawingBoard stay active
 	UPROPERTY()
 	TArray<AWorldInteractVolume*> ActiveVolumes;
@@ -51,8 +194,239 @@ private:
 
 	//Bind or Unbind this DrawingBoard to InteractVolumes
 	void ReBindInteractVolumes(bool bBind);
+
+	//Add a rotated quad,in wrap around mode also add its copies on the other side of RT
+	void AddQuad(FIWTriangleList& TriangleList, const FVector2D (&Vertices)[4], FVector2D CoordinatePosition, FVector2D CoordinateSize, const FLinearColor& VertexColor);
+	//Add two triangles of a quad to TriangleList
+	void AddQuadTriangles(FIWTriangleList& TriangleList, const FVector2D (&Vertices)[4], FVector2D CoordinatePosition, FVector2D CoordinateSize, const FLinearColor& VertexColor);
+
+	//In wrap around mode,split a world rect of canvas to pixel rects of RT
+	void AddWrappedPixelRects(const FBox2D& WorldRect, TArray<FBox2D>& OutRects) const;
+
+	//In wrap around mode,get pixel rects of RT which canvas exposed since it was at OldLocation with OldSize and OldRTSize
+	void GetExposedPixelRects(const FVector2D& OldLocation, const FVector2D& OldSize, const FVector2D& OldRTSize, TArray<FBox2D>& OutRects) const;
+
+	//RenderTargets acquired for PooledRenderTargetSlots,same order
+	UPROPERTY()
+	TArray<UTextureRenderTarget2D*> PooledRenderTargets;
+
+	//Compressed content of released RenderTargets,same order as PooledRenderTargetSlots
+	TArray<TArray<uint8>> SavedRenderTargetContents;
+
+	//Released RenderTargets whose content is being read back,returned to pool once saved
+	UPROPERTY()
+	TArray<UTextureRenderTarget2D*> SavingRenderTargets;
+
+	//Readbacks of SavingRenderTargets,same order
+	TArray<TSharedPtr<FIWContentReadback, ESPMode::ThreadSafe>> ContentReadbacks;
+
+	//RenderTargets acquired for RenderTargetRings,buffers of each ring are adjacent
+	UPROPERTY()
+	TArray<UTextureRenderTarget2D*> RingRenderTargets;
+
+	//Index of first buffer in RingRenderTargets and current buffer of each ring,same order as RenderTargetRings
+	TArray<int32> RingFirstBuffers;
+	TArray<int32> RingCurrentBuffers;
+
+	//Materials that sample buffers of rings
+	UPROPERTY()
+	TArray<UMaterialInstanceDynamic*> RingMaterials;
+
+	//Buffer of ring at RingIndex,Age 0 is current buffer
+	UTextureRenderTarget2D* GetRingBuffer(int32 RingIndex, int32 Age) const;
+
+	//Rotate a ring without updating materials
+	void RotateRing(int32 RingIndex);
+
+	//Set buffers of rings to registered materials,and current buffer as RTDrawOn for rings with bDrawOn
+	void UpdateRingParameters();
+
+	//Rotate rings with bAdvanceEachStep,at the end of a step
+	void AdvanceRingsForStep();
+
+	//In wrap around mode,clear exposed area of RTDrawOn and every buffer of rings
+	void ClearExposedBuffers();
+
+	//Clear PixelRects of RenderTarget,rects are in pixels of RTDrawOn
+	void ClearPixelRects(UTextureRenderTarget2D* RenderTarget, const TArray<FBox2D>& PixelRects, const FLinearColor& ClearColor);
+
+	//Pixel rects exposed in this frame,kept between frames so steady state doesn't allocate
+	TArray<FBox2D> ExposedPixelRects;
+
+	//How long this DrawingBoard is not simulating
+	float TimeFromLastSimulate = 0;
+
+	//Acquire RenderTargets of PooledRenderTargetSlots if not acquired
+	void AcquirePooledRenderTargets();
+
+	//Return RenderTargets of PooledRenderTargetSlots to pool
+	void ReleasePooledRenderTargets(bool bKeepContent);
+
+	//Start reading back RenderTarget of a slot without stalling game thread.False if it has no resource
+	bool BeginSaveRenderTargetContent(int32 SlotIndex, UTextureRenderTarget2D* RenderTarget);
+
+	//Move finished saves to SavedRenderTargetContents and return their RenderTargets to pool,every tick
+	void UpdateContentSaves();
+
+	//Take back RenderTarget of a slot that is still being saved,its content is still there.Null if there is none
+	UTextureRenderTarget2D* TakeSavingRenderTarget(int32 SlotIndex);
+
+	//Drop saves in progress and return their RenderTargets to pool
+	void CancelContentSaves();
+
+	//Decompress content and draw it on RenderTarget
+	void RestoreRenderTargetContent(UTextureRenderTarget2D* RenderTarget, const TArray<uint8>& Content);
+
+	//Saved content is uploaded here before drawn on RenderTarget,reused by every restore of the same size and format
+	UPROPERTY()
+	UTexture2D* RestoreContentTexture;
+
+	//Instances of parallel brushes are built this frame,so DrawBrushes only runs the others
+	bool bParallelInstancesBuilt = false;
+
+	//Pixel rects brushes drew on recently
+	FIWDirtyRegionTracker DirtyRegions;
+
+	//Canvas location that DirtyRegions are relative to
+	FVector2D DirtyRegionsCanvasLocation = FVector2D::ZeroVector;
+
+	//Copy settings to DirtyRegions,and move regions with canvas if canvas moved since last call
+	void UpdateDirtyRegions();
+
+	//Set dirty bounds to ParameterCollection
+	void PublishDirtyRegions();
+
+	//Fingerprint of what each brush drew last time,for bElideRepeatedStamps
+	TMap<TObjectKey<UInteractBrush>, uint32> StampFingerprints;
+
+	//Fingerprints of destroyed brushes are removed when map grows over this
+	int32 StampFingerprintsPruneSize = 64;
+
+	//Triangle count of each list before a brush draws,reused for every brush
+	TArray<TPair<UMaterialInterface*, int32>> FingerprintListStarts;
+
+	//While a native brush draws for elision,its quads are kept here instead of DirtyRegions.Reused for every brush
+	bool bDeferDirtyRects = false;
+	TArray<FBox2D> DeferredDirtyRects;
+
+	//Canvas part of fingerprints,so moving canvas makes every brush draw again.
+	//RTDrawOn is left out,simulation carries content to the next buffer of a ring
+	uint32 GetCanvasFingerprint() const;
+
+	//Let brush draw by Draw,which returns false if everything was culled.
+	//If it would draw the same as last time on this canvas,skip it or drop its triangles.Return if brush is on canvas.
+	//On worker threads AccumulativeMaterials is the game thread cache,materials not in it are never elided.
+	//Null on game thread,where materials are checked directly
+	bool DrawBrushWithElision(const UInteractBrush* Brush, TFunctionRef<bool()> Draw,
+	                          const TMap<const UMaterialInterface*, bool>* AccumulativeMaterials = nullptr);
+
+	//Brushes of BuildParallelInstances that are on canvas,by index in brushes array
+	TBitArray<> ParallelDrawnBrushes;
+
+	//Remember fingerprint of brush,and remove fingerprints of destroyed brushes sometimes
+	void SetStampFingerprint(const UInteractBrush* Brush, uint32 Fingerprint);
+
+	//Set analytic time to ParameterCollection,every frame even when sleeping
+	void PublishAnalyticTime();
+
+	//Trails drawn with analytic decay may not be fully recovered yet,so RenderTargets must be kept
+	bool HasAnalyticContent() const;
+
+	//Set canvas parameters to ParameterCollection,every frame even when sleeping.Unchanged values cost nothing
+	void PublishCanvasParameters();
+
+	//Write a vector parameter of ParameterCollection through subsystem,skipped if ParameterName is None
+	void SetCollectionVectorParameter(FName ParameterName, const FLinearColor& Value) const;
+
+	//Push parameters before simulation passes read them
+	void FlushCollectionParameters() const;
+
+	//Loaded baked tiles around canvas
+	UPROPERTY()
+	TMap<FIntPoint, UTexture2D*> LoadedBakedTiles;
+
+	//Loading baked tiles
+	TSharedPtr<FStreamableHandle> BakedTilesLoadHandle;
+
+	//Resident mips of loaded tiles when last composited,composite again when more mips arrive
+	TMap<FIntPoint, int32> BakedTileResidentMips;
+
+	//Last time loaded tiles were forced resident
+	double BakedTilesResidentTime = -1;
+
+	//Canvas when BakedLayerRT was composited,or tiles changed so it should be composited again
+	bool bBakedLayerDirty = true;
+	FVector4 BakedLayerCanvas = FVector4(0, 0, 0, 0);
+	float BakedLayerCanvasYaw = 0;
+
+	//Content of BakedLayerRT is shifted here when canvas moves without wrap around
+	UPROPERTY()
+	UTextureRenderTarget2D* BakedLayerShiftRT;
+
+	//Pixel rects of BakedLayerRT exposed by canvas movement
+	TArray<FBox2D> BakedLayerExposedRects;
+
+	//Triangles of one tile in CompositeBakedLayer,kept between frames so steady state doesn't allocate
+	TArray<FCanvasUVTri> BakedLayerTriangles;
+
+	//Load tiles around canvas,and composite them when canvas moved or tiles streamed in
+	void UpdateBakedLayer();
+
+	//Canvas moved from OldLocation,keep what BakedLayerRT already has and find pixel rects to composite.
+	//Return false if everything should be composited
+	bool PrepareBakedLayerExposedRects(const FVector2D& OldLocation);
+
+	//Draw loaded tiles on BakedLayerRT,only inside PixelRects if not null
+	void CompositeBakedLayer(const TArray<FBox2D>* PixelRects = nullptr);
+
+	//Most triangles drawn in one DispatchDrawInstances
+	int32 PeakTriangleCount = 0;
+
+	//Frame scoped buffers,kept between frames so steady state doesn't allocate
+	TArray<FIWBrushInstance> StampInstancesBuffer;
+	TArray<const FIWBakedTile*> BakedTilesInCanvas;
+
+	//Time not simulated yet,less than a step.Negative when a step is borrowed for canvas movement
+	float SimulationTimeAccumulator = 0;
+	float SimulationDeltaTime = 0;
+	float SimulationInterpolationAlpha = 1;
+	int32 SimulationStepIndex = 0;
+	int32 SimulationStepCount = 0;
+
+	//Add frame time to accumulator,return how many steps to simulate this frame
+	int32 AdvanceSimulationTime();
+
+	//Canvas moved,resized or rotated since last simulation
+	bool HasCanvasMoved() const;
+
+	//Run steps of "Pre Simulate" and "Post Simulate",brushes draw in first step
+	void RunSimulationSteps(int32 NumSteps, const TArray<UInteractBrush*>* Brushes);
+
+	//Draw brushes and instances on RTDrawOn,or drop instances if there is no RTDrawOn
+	void DrawOnRTDrawOn(const TArray<UInteractBrush*>& Brushes);
+
+	//RTSize at scale 1,taken again whenever RTSize is set by user
+	FVector2D FullRTSize = FVector2D::ZeroVector;
+	//RTSize after last scale update,so sizes set by user are told apart
+	FVector2D ScaledRTSize = FVector2D::ZeroVector;
+	float RTScale = 1;
 	
 protected:
+	//This map stores triangles that desired to draw as instances
+	UPROPERTY()
+	TMap<UMaterialInterface*,FIWTriangleList> TriangleInstancesMap;
+
+	//Let brushes draw on canvas,skip brushes whose instances are built in parallel
+	void DrawBrushesOnCanvas(const TArray<UInteractBrush*>& Brushes, UCanvas* CanvasDrawOn, FVector2D CanvasSize);
+
+	//Shift content of RenderTarget by whole pixels through ScratchRT,so it isn't read and written in one pass.
+	//Exposed pixels are cleared to ClearColor of RenderTarget,ScratchRT is created or resized when needed
+	void ShiftRenderTargetContent(UTextureRenderTarget2D* RenderTarget, FVector2D PixelOffset, UTextureRenderTarget2D*& ScratchRT);
+
+	//Called before "Pre Simulate" of the first step when canvas moved,for RenderTargets that simulation passes don't shift.
+	//Previous canvas parameters are still the ones of last simulation
+	virtual void OnCanvasMoved() {}
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
@@ -68,6 +442,19 @@ protected:
 	//Save how long time form last time there are brush draw on this DrawingBoard
 	float TimeFromLastDraw;
 
+	//Analytic Decay//
+
+	//Recover trails in sampling materials by time,instead of simulation passes rewriting RT every frame.
+	//Brush materials write AnalyticTimeParameterName into a channel,sampling materials compute recovery from its age.
+	//Nothing is simulated without drawing,so this DrawingBoard sleeps right after the last stamp
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Analytic Decay")
+	bool bAnalyticDecay = false;
+
+	//Published time wraps in this period,so it stays precise in 16 bit RenderTargets.
+	//Compute age as frac((Time - Stamp) / Period) * Period,so it should be longer than the longest recovery
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Analytic Decay",meta = (ClampMin = 1,editcondition = "bAnalyticDecay"))
+	float AnalyticTimePeriod = 600;
+
 	//Simulating RT//
 	
 	//The RT that all brush will draw on this frame
@@ -107,6 +494,108 @@ protected:
 	UPROPERTY(BlueprintReadWrite,Category = "World Drawing Board | Canvas")
 	float PreviousCanvasWorldYaw;
 
+	//Address RenderTarget by world location modulo canvas size,so moving canvas only needs to clear newly exposed area instead of shifting whole RT.
+	//When enabled,simulation should not shift RT content,sampling materials should use frac(WorldLocation / CanvasWorldSize) as UV.CanvasWorldYaw is set to 0 in BeginPlay and ignored by World to Canvas functions.
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Simulating RT")
+	bool bWrapAroundCanvas = false;
+
+	//In wrap around mode,newly exposed area will be cleared to this color
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Simulating RT",meta = (editcondition = "bWrapAroundCanvas"))
+	FLinearColor WrapClearColor = FLinearColor::Black;
+
+	//Render Target Pool//
+
+	//RenderTargets acquired from subsystem when this DrawingBoard starts simulating,and released after sleeping for ReleaseRenderTargetsDelay.
+	//Use "Get Pooled Render Target" and "On Render Targets Acquired" to use them.
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "World Drawing Board | Render Target Pool")
+	TArray<FIWPooledRenderTargetSlot> PooledRenderTargetSlots;
+
+	//Seconds not simulating before pooled RenderTargets are released.If less than 0,never release
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Render Target Pool")
+	float ReleaseRenderTargetsDelay = 10;
+
+	//Rings of RenderTargets acquired and released with PooledRenderTargetSlots.Content is not kept when released
+	UPROPERTY(EditAnywhere,BlueprintReadOnly,Category = "World Drawing Board | Render Target Pool")
+	TArray<FIWRenderTargetRing> RenderTargetRings;
+
+	//Dirty Region//
+
+	//Track pixel rects that brushes drew on,so simulation can scissor or early-out outside them
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Dirty Region")
+	bool bTrackDirtyRegions = false;
+
+	//Max dirty rects,more will be merged
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Dirty Region",meta = (editcondition = "bTrackDirtyRegions",ClampMin = 1))
+	int32 DirtyRegionMaxRects = 4;
+
+	//Frames a region stays dirty after last drawn,for simulation still settling,like water waves
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Dirty Region",meta = (editcondition = "bTrackDirtyRegions",ClampMin = 0))
+	int32 DirtyRegionSettleFrames = 0;
+
+	//Pixels added around each dirty rect,for simulation spreading outward
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Dirty Region",meta = (editcondition = "bTrackDirtyRegions",ClampMin = 0))
+	float DirtyRegionPadding = 2;
+
+	//Stamp Elision//
+
+	//Skip brushes that would stamp the same quads on the same pixels as their last draw,like stationary crowds.
+	//Fingerprints are quantized to pixels,so brushes only moving by jitter are skipped too.
+	//Only for content that doesn't change between draws,a decaying trail would stop refreshing under a still brush.
+	//Works on native brushes and brushes with "Cache World Stamps".Materials with accumulative "Interact Stamp Material Data" always draw
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Stamp Elision")
+	bool bElideRepeatedStamps = false;
+
+	//Instances//
+
+	//Rotate brush instances around their whole Pivot Point.
+	//Off by default,pivot Y stays on top edge of the quad like former versions,so existing content keeps its look
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Instances")
+	bool bRotateAroundPivotPoint = false;
+
+	//Scalability//
+
+	//Scale RenderTargets with subsystem's RT scale,which follows effects quality,"iw.RTScale" and the governor.
+	//Content is resampled when resized.Resize your other simulating RTs in "On Render Targets Resized"
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Scalability")
+	bool bFollowScalability = false;
+
+	//Baked Layer//
+
+	//Static interaction baked in editor.Tiles around canvas are composited on BakedLayerRT as a base layer
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Baked Layer")
+	UInteractBakedLayer* BakedLayer;
+
+	//Baked tiles around canvas,same size and mapping as RT Draw On.Sample it with simulating RT in materials
+	UPROPERTY(BlueprintReadOnly,Category = "World Drawing Board | Baked Layer")
+	UTextureRenderTarget2D* BakedLayerRT;
+
+	//Material Parameters//
+
+	//MaterialParameterCollection that native parameters of this DrawingBoard will be set to,like MPC_InteractiveWorld.
+	//Parameters are written through subsystem,only changed values are pushed
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Material Parameters")
+	UMaterialParameterCollection* ParameterCollection;
+
+	//Vector parameter for canvas.R,G:CanvasWorldLocation,B,A:CanvasWorldSize.None to skip
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Material Parameters")
+	FName CanvasParameterName;
+
+	//Vector parameter for canvas of last simulation.R,G:PreviousCanvasWorldLocation,B,A:PreviousCanvasWorldSize.None to skip
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Material Parameters")
+	FName PreviousCanvasParameterName;
+
+	//Vector parameter for pixels.R,G:PixelWorldSize,B:CanvasWorldYaw,A:PreviousCanvasWorldYaw.None to skip
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Material Parameters")
+	FName PixelParameterName;
+
+	//Vector parameter for union of dirty rects in UV.R,G:Min,B,A:Max.Min is greater than Max when nothing is dirty.None to skip
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Material Parameters")
+	FName DirtyBoundsParameterName;
+
+	//Vector parameter for analytic decay.R:Time wrapped in AnalyticTimePeriod,G:AnalyticTimePeriod.None to skip
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Material Parameters",meta = (editcondition = "bAnalyticDecay"))
+	FName AnalyticTimeParameterName;
+
 	//Simulating//
 	
 	//If this DrawingBoard should move with RenderTarget pixel aligned with last time.
@@ -117,6 +606,15 @@ protected:
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Simulating")
 	float InteractHeight = 30.0;
 
+	//Simulation steps per second,each step calls "Pre Simulate" and "Post Simulate" once.Frames may run 0 or more steps,
+	//brushes still draw every frame and their stamps accumulate on RT until next step.If 0,simulate once every tick
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Simulating",meta = (ClampMin = 0))
+	float SimulationRate = 0;
+
+	//Time over this many steps in one frame is dropped,so a slow frame doesn't make next frames slower
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "World Drawing Board | Simulating",meta = (ClampMin = 1,editcondition = "SimulationRate > 0"))
+	int32 MaxSimulationStepsPerFrame = 4;
+
 	//Active Mode//
 	
 	//Active this DrawingBoard
@@ -139,16 +637,45 @@ public:
 
 	//SubSystem allocated InteractBrushes,and can this function.
 	//Receive InteractBrushes,and prepare for simulate
-	void PrepareForSimulate(TArray<UInteractBrush*> Brushes);
+	void PrepareForSimulate(const TArray<UInteractBrush*>& Brushes);
 	//No InteractBrush for this DrawingBoard.Prepare for simulate
 	void PrepareForSimulate();
 
+	//If there are instances waiting for DispatchDrawInstances,like stamps allocated by subsystem
+	bool HasPendingInstances() const;
+
 	//Before drawing brushes
 	UFUNCTION(BlueprintNativeEvent,meta=(DisplayName="Pre Simulate"))
 	void PreSimulate();
 
+	//Fixed Rate//
+
+	//Seconds simulated by this step,1 / SimulationRate.Frame time if SimulationRate is 0
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Simulation Delta Time"), Category="World Drawing Board | Simulating")
+	float GetSimulationDeltaTime() const {return SimulationDeltaTime;}
+
+	//Index of this step in this frame,and steps in this frame
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Simulation Step"), Category="World Drawing Board | Simulating")
+	void GetSimulationStep(int32& OutStepIndex, int32& OutStepCount) const {OutStepIndex = SimulationStepIndex;OutStepCount = SimulationStepCount;}
+
+	//Where this step ends in this frame,from 0 to 1.For interpolating inputs between sub steps
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Simulation Step Alpha"), Category="World Drawing Board | Simulating")
+	float GetSimulationStepAlpha() const {return SimulationStepCount > 0 ? static_cast<float>(SimulationStepIndex + 1) / SimulationStepCount : 1.f;}
+
+	//Time after last step in steps,from 0 to 1.For rendering between last two simulated states
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Simulation Interpolation Alpha"), Category="World Drawing Board | Simulating")
+	float GetSimulationInterpolationAlpha() const {return SimulationInterpolationAlpha;}
+
+	//Add materials of pending instances to Cache.Called by subsystem on game thread before BuildParallelInstances
+	void CacheAccumulativeMaterials(TMap<const UMaterialInterface*, bool>& Cache) const;
+
+	//Build instances of brushes that can draw in parallel.Called by subsystem on worker threads before PrepareForSimulate,
+	//AccumulativeMaterials is only read
+	void BuildParallelInstances(const TArray<UInteractBrush*>& Brushes,
+	                            const TMap<const UMaterialInterface*, bool>& AccumulativeMaterials);
+
 	//Draw brushes
-	void DrawBrushes(TArray<UInteractBrush*> Brushes,UTextureRenderTarget2D* RTDrawOn);
+	virtual void DrawBrushes(const TArray<UInteractBrush*>& Brushes,UTextureRenderTarget2D* RTDrawOn);
 
 	// After drawing brushes
 	UFUNCTION(BlueprintNativeEvent,meta=(DisplayName="Post Simulate"))
@@ -165,20 +692,108 @@ public:
 	//Transform World to Canvas//
 	
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="World to Canvas Rotation"), Category="World Drawing Board | World to Canvas")
-	float WorldToCanvasRotation(float WorldRotation);
+	float WorldToCanvasRotation(float WorldRotation) const;
 
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="World to Canvas Size"), Category="World Drawing Board | World to Canvas")
-	FVector2D WorldToCanvasSize(FVector2D WorldSize);
+	FVector2D WorldToCanvasSize(FVector2D WorldSize) const;
 
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="World to Canvas UV"), Category="World Drawing Board | World to Canvas")
-	FVector2D WorldToCanvasUV(FVector2D WorldLocation);
+	FVector2D WorldToCanvasUV(FVector2D WorldLocation) const;
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Wrap Around Canvas"), Category="World Drawing Board | World to Canvas")
+	bool GetWrapAroundCanvas() const {return bWrapAroundCanvas;}
+
+	//In wrap around mode,get pixel rects of RT which canvas exposed since last update
+	void GetExposedCanvasPixelRects(TArray<FBox2D>& OutRects) const;
+
+	//In wrap around mode,get pixel rects of RT which canvas exposed since last update.X,Y:Position,Z,W:Size
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Exposed Canvas Rects"), Category="World Drawing Board | World to Canvas")
+	TArray<FVector4> GetExposedCanvasRects() const;
+
+	//In wrap around mode,clear area of RT which canvas exposed since last update.RTDrawOn and rings are cleared automatically,call this for other simulating RTs
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Clear Exposed Canvas"), Category="World Drawing Board | World to Canvas")
+	void ClearExposedCanvas(UTextureRenderTarget2D* RenderTarget);
 
 	//This is actually a box SDF
-	float GetNearestDistance(FVector2D WorldLocation) const;
+	virtual float GetNearestDistance(FVector2D WorldLocation) const;
 
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="World to Canvas Brush"), Category="World Drawing Board | World to Canvas")
 	void WorldToCanvasBrush(FVector2D BrushLocation,FVector2D BrushSize,float BrushRotation,FVector2D& OutScreenPosition,FVector2D& OutScreenSize,float& OutScreenRotation);
 
+	//Mark Radius around both ends of a brush move dirty,for brushes that draw on canvas in Blueprint.
+	//Instances mark their own quads
+	void MarkBrushAreaDirty(FVector2D FromLocation, FVector2D ToLocation, float Radius);
+
+
+	//Render Target Pool//
+
+	//Called by subsystem every tick,release pooled RenderTargets if this DrawingBoard sleeps long enough
+	void UpdatePooledRenderTargets(float DeltaTime);
+
+	//Pooled RenderTargets are acquired,set them to materials here.RTDrawOn is already set if any slot has bDrawOn
+	UFUNCTION(BlueprintNativeEvent,meta=(DisplayName="On Render Targets Acquired"))
+	void OnRenderTargetsAcquired();
+
+	//Scalability//
+
+	//Called by subsystem every tick,resize RenderTargets if scale changed and bFollowScalability
+	void UpdateRenderTargetScale(float NewRTScale);
+
+	//RenderTargets are resized with content kept,RTSize and PixelWorldSize are updated
+	UFUNCTION(BlueprintNativeEvent,meta=(DisplayName="On Render Targets Resized"))
+	void OnRenderTargetsResized();
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get RT Scale"), Category="World Drawing Board | Scalability")
+	float GetRTScale() const {return RTScale;}
+
+	//Pooled RenderTargets are released,stop using them here
+	UFUNCTION(BlueprintNativeEvent,meta=(DisplayName="On Render Targets Released"))
+	void OnRenderTargetsReleased();
+
+	//Find pooled RenderTarget by slot name,nullptr if not acquired
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Pooled Render Target"), Category="World Drawing Board | Render Target Pool")
+	UTextureRenderTarget2D* GetPooledRenderTarget(FName SlotName) const;
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Render Targets Acquired"), Category="World Drawing Board | Render Target Pool")
+	bool GetRenderTargetsAcquired() const {return PooledRenderTargets.Num() > 0 || RingRenderTargets.Num() > 0;}
+
+	//Buffer of a ring,Age 0 is current buffer,1 is previous buffer.nullptr if not acquired
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Ring Render Target"), Category="World Drawing Board | Render Target Pool")
+	UTextureRenderTarget2D* GetRingRenderTarget(FName RingName, int32 Age = 0) const;
+
+	//Rotate a ring,current buffer becomes previous one and the oldest one becomes current.Materials and RTDrawOn are updated
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Advance Render Target Ring"), Category="World Drawing Board | Render Target Pool")
+	void AdvanceRenderTargetRing(FName RingName);
+
+	//Material will get texture parameters of rings whenever they rotate
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Register Ring Material"), Category="World Drawing Board | Render Target Pool")
+	void RegisterRingMaterial(UMaterialInstanceDynamic* Material);
+
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Unregister Ring Material"), Category="World Drawing Board | Render Target Pool")
+	void UnregisterRingMaterial(UMaterialInstanceDynamic* Material);
+
+	//Dirty Region//
+
+	//Dirty rects in UV,including settling ones.X,Y:Min,Z,W:Max.
+	//In PreSimulate,this only contains rects of former frames and stamps.In PostSimulate,brushes of this frame are included
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Dirty Rects"), Category="World Drawing Board | Dirty Region")
+	TArray<FVector4> GetDirtyRects() const;
+
+	//Union of dirty rects in UV.X,Y:Min,Z,W:Max.Return false if nothing is dirty
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Dirty Bounds"), Category="World Drawing Board | Dirty Region")
+	bool GetDirtyBounds(FVector4& OutBounds) const;
+
+	const FIWDirtyRegionTracker& GetDirtyRegionTracker() const {return DirtyRegions;}
+
+	//Baked Layer//
+
+	//Draw brushes with bBakeToLayer that can draw on this DrawingBoard into tiles of BakedLayer,tile textures are created next to BakedLayer.
+	//Save BakedLayer and textures after baking
+	UFUNCTION(CallInEditor,Category = "World Drawing Board | Baked Layer")
+	void BakeLayer();
+
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Baked Layer RT"), Category="World Drawing Board | Baked Layer")
+	UTextureRenderTarget2D* GetBakedLayerRT() const {return BakedLayerRT;}
 
     //Interact Volume//
 	
@@ -213,7 +828,7 @@ public:
 
 	//Although there may be some InteractBrushes,but there are no successful draw,then this DrawingBoard will sleep 
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Is Simulating"), Category="World Drawing Board")
-	bool GetIsSimulating(); 
+	bool GetIsSimulating() const;
 
 	//Get private properties//
 	
@@ -223,6 +838,13 @@ public:
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Time from Last Draw"), Category="World Drawing Board")
 	float GetTimeFromLastDraw() const {return  TimeFromLastDraw;}
 
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Analytic Decay"), Category="World Drawing Board | Analytic Decay")
+	bool GetAnalyticDecay() const {return bAnalyticDecay;}
+
+	//Time written by brushes for analytic decay,wrapped in AnalyticTimePeriod
+	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(DisplayName="Get Analytic Time"), Category="World Drawing Board | Analytic Decay")
+	float GetAnalyticTime() const;
+
 	//RT Draw On
 	UFUNCTION(BlueprintCallable,meta=(DisplayName="Set RT Draw On"), Category="World Drawing Board")
 	void SetRTDrawOn(UTextureRenderTarget2D* NewRT);
@@ -234,6 +856,39 @@ public:
 	UFUNCTION(BlueprintCallable,meta=(DisplayName="Add Brush Instance"), Category="World Drawing Board")
 	void AddBrushInstance(UMaterialInterface* RenderMaterial, FVector2D ScreenPosition, FVector2D ScreenSize, FVector2D CoordinatePosition, FVector2D CoordinateSize=FVector2D::UnitVector, float Rotation=0.f, FVector2D PivotPoint=FVector2D(0.5f,0.5f), FLinearColor VertexColor=FLinearColor::White);
 
+	//Add many instances of one material in one pass,much cheaper than calling AddBrushInstance for each
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Add Brush Instances"), Category="World Drawing Board")
+	void AddBrushInstances(UMaterialInterface* RenderMaterial, const TArray<FIWBrushInstance>& Instances);
+
+	//Transform world space stamps to canvas,and add them as brush instances.Stamps outside canvas will be culled
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Add Stamp Instances"), Category="World Drawing Board")
+	void AddStampInstances(UMaterialInterface* RenderMaterial, const TArray<FIWStamp>& Stamps);
+
+	//Transform world stamps cached by brushes to canvas,and add them as brush instances.Stamps outside canvas will be culled
+	//Return how many stamps were added
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Add World Stamp Instances"), Category="World Drawing Board")
+	int32 AddWorldStampInstances(const TArray<FIWWorldStamp>& Stamps);
+
+	//Add one world stamp as brush instance,return false if it is culled
+	bool AddWorldStampInstance(const FIWWorldStamp& Stamp);
+
+	//Forget what brushes drew,so all of them draw next time.Call it after clearing RTDrawOn yourself
+	UFUNCTION(BlueprintCallable,meta=(DisplayName="Reset Stamp Fingerprints"), Category="World Drawing Board")
+	void ResetStampFingerprints() {StampFingerprints.Reset();}
+
 	//Draw instances that stored in TriangleInstancesMap, then clear that.
 	void DispatchDrawInstances(UCanvas* CanvasDrawOn);
+
+	//Draw instances that stored in TriangleInstancesMap,and keep them
+	void DrawPendingInstances(UCanvas* CanvasDrawOn);
+
+	//Clear instances but keep memory of triangle lists for next frame.Lists of materials not used since last reset are freed
+	void ResetPendingInstances();
+
+	//Memory//
+
+	//RenderTargets this DrawingBoard holds,without duplicates
+	virtual void GetRenderTargets(TArray<UTextureRenderTarget2D*>& OutRenderTargets) const;
+
+	void GetMemoryStats(FIWDrawingBoardMemoryStats& OutStats) const;
 };
\ No newline at end of file
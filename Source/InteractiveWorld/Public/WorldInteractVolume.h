@@ -19,6 +19,7 @@ class INTERACTIVEWORLD_API AWorldInteractVolume : public APhysicsVolume
 	AWorldInteractVolume();
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	//Brushes in this volume
 	UPROPERTY()
@@ -68,6 +69,10 @@ public:
 	
 	void RemoveBrush(UInteractBrush* InteractBrush);
 
+	//Brushes of actors overlapping this volume enter it,for brushes activated after their actors' overlaps were updated.
+	//Update DrawingBoards once for all
+	void AddOverlappingBrushes(const TArray<UInteractBrush*>& InteractBrushes);
+
 	//Reset active state,this will find overlapping actors and check it they have suitable brushes
 	//After binding or unbinding DrawingBoard,call this to update
 	void ResetActiveState();
@@ -77,6 +82,11 @@ public:
 
 	UFUNCTION(BlueprintCallable,meta = (DisplayName = "Manual InteractBrush Leave Area", Keywords = "Interact,Brush"), Category = "World Interact Volume")
 	void ManualInteractBrushLeaveArea(UInteractBrush* InteractBrush);
+
+	//For Debugging
+	int32 GetNumOverlappingBrushes() const {return OverlappingBrushes.Num();}
+	int32 GetNumManualAddingBrushes() const {return ManualAddingBrushes.Num();}
+	bool GetVolumeActive() const {return bVolumeActive;}
 	
 };
 
@@ -0,0 +1,25 @@
+// Copyright 2023 Sun BoHeng
+
+using UnrealBuildTool;
+
+public class InteractiveWorldMass : ModuleRules
+{
+	public InteractiveWorldMass(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"MassEntity",
+				"MassCommon",
+				"MassSpawner",
+				"StructUtils",
+				"InteractiveWorld",
+			}
+			);
+	}
+}
@@ -0,0 +1,141 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractBrushMassProcessor.h"
+
+#include "InteractBrushMassFragments.h"
+#include "InteractiveWorld.h"
+#include "InteractiveWorldSubsystem.h"
+#include "MassCommonFragments.h"
+#include "MassCommonTypes.h"
+#include "MassExecutionContext.h"
+
+UInteractBrushMassProcessor::UInteractBrushMassProcessor()
+{
+	bAutoRegisterWithProcessingPhases = true;
+	//Nothing to draw on dedicated server
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::Client | EProcessorExecutionFlags::Standalone);
+	ProcessingPhase = EMassProcessingPhase::PostPhysics;
+	ExecutionOrder.ExecuteAfter.Add(UE::Mass::ProcessorGroupNames::Movement);
+}
+
+void UInteractBrushMassProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FIWMassBrushFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddSharedRequirement<FIWMassBrushParameters>(EMassFragmentAccess::ReadOnly);
+}
+
+void UInteractBrushMassProcessor::Execute(UMassEntitySubsystem& EntitySubsystem, FMassExecutionContext& Context)
+{
+	UInteractiveWorldSubsystem* InteractiveWorldSubsystem = UWorld::GetSubsystem<UInteractiveWorldSubsystem>(EntitySubsystem.GetWorld());
+	if (!InteractiveWorldSubsystem)
+	{
+		return;
+	}
+	LLM_SCOPE_BYTAG(InteractiveWorld);
+
+	//Same culling as InteractBrushes,viewers are snapshotted once for all chunks
+	const FIWViewerSet* Viewers = nullptr;
+	const bool bUseCulling = InteractiveWorldSubsystem->GetBrushCullViewers(Viewers);
+	const float CullDistance = bUseCulling ? Viewers->GetCullDistance() : 0.f;
+	ViewerX.Reset();
+	ViewerY.Reset();
+	if (bUseCulling)
+	{
+		for (const FVector& ViewerLocation : Viewers->GetViewers())
+		{
+			ViewerX.Add(ViewerLocation.X);
+			ViewerY.Add(ViewerLocation.Y);
+		}
+	}
+	const int32 NumViewers = ViewerX.Num();
+
+	EntityQuery.ForEachEntityChunk(EntitySubsystem, Context, [&](FMassExecutionContext& ChunkContext)
+	{
+		const FIWMassBrushParameters& Parameters = ChunkContext.GetSharedFragment<FIWMassBrushParameters>();
+		if (!Parameters.Material)
+		{
+			return;
+		}
+		const TConstArrayView<FTransformFragment> Transforms = ChunkContext.GetFragmentView<FTransformFragment>();
+		const TArrayView<FIWMassBrushFragment> BrushFragments = ChunkContext.GetMutableFragmentView<FIWMassBrushFragment>();
+		const int32 NumEntities = ChunkContext.GetNumEntities();
+
+		//Gather into flat arrays first,so the tests below are simple loops over floats
+		TArray<float, TInlineAllocator<256>> LocationX;
+		TArray<float, TInlineAllocator<256>> LocationY;
+		TArray<float, TInlineAllocator<256>> Yaw;
+		LocationX.SetNumUninitialized(NumEntities);
+		LocationY.SetNumUninitialized(NumEntities);
+		Yaw.SetNumUninitialized(NumEntities);
+		for (int32 i = 0; i < NumEntities; i++)
+		{
+			const FTransform& Transform = Transforms[i].GetTransform();
+			const FVector Forward = Transform.GetRotation().GetForwardVector();
+			LocationX[i] = Transform.GetLocation().X;
+			LocationY[i] = Transform.GetLocation().Y;
+			Yaw[i] = FMath::RadiansToDegrees(FMath::Atan2(Forward.Y, Forward.X));
+		}
+
+		//Culling mask,one pass over the chunk for each viewer.Same test as FIWViewerSet::IsInRange
+		TArray<uint8, TInlineAllocator<256>> InRange;
+		InRange.Init(!bUseCulling, NumEntities);
+		const float CullRange = CullDistance + Parameters.Size.Length();
+		const float CullRangeSquared = CullRange * CullRange;
+		for (int32 ViewerIndex = 0; ViewerIndex < NumViewers; ViewerIndex++)
+		{
+			const float X = ViewerX[ViewerIndex];
+			const float Y = ViewerY[ViewerIndex];
+			for (int32 i = 0; i < NumEntities; i++)
+			{
+				const float DX = LocationX[i] - X;
+				const float DY = LocationY[i] - Y;
+				InRange[i] |= DX * DX + DY * DY <= CullRangeSquared;
+			}
+		}
+
+		//Movement tolerance,result is a mask
+		const float PositionToleranceSquared = Parameters.MovementTolerance.X * Parameters.MovementTolerance.X;
+		const float RotationTolerance = Parameters.MovementTolerance.Y;
+		TArray<uint8, TInlineAllocator<256>> ShouldStamp;
+		ShouldStamp.SetNumUninitialized(NumEntities);
+		int32 NumStamps = 0;
+		for (int32 i = 0; i < NumEntities; i++)
+		{
+			const FIWMassBrushFragment& Brush = BrushFragments[i];
+			const float MoveX = LocationX[i] - Brush.LastStampLocation.X;
+			const float MoveY = LocationY[i] - Brush.LastStampLocation.Y;
+			const float Turn = FMath::Abs(FRotator::NormalizeAxis(Yaw[i] - Brush.LastStampYaw));
+			const bool bMoved = MoveX * MoveX + MoveY * MoveY > PositionToleranceSquared || Turn > RotationTolerance;
+			ShouldStamp[i] = InRange[i] & (bMoved | !Brush.bHasStamped);
+			NumStamps += ShouldStamp[i];
+		}
+		if (NumStamps == 0)
+		{
+			return;
+		}
+
+		//Fill a recycled batch in place,so steady state doesn't allocate
+		FIWStampBatch* Batch = InteractiveWorldSubsystem->AllocateStampBatch(Parameters.Material, Parameters.DrawingBoardClass);
+		TArray<FIWStamp>& Stamps = Batch->Stamps;
+		Stamps.Reserve(NumStamps);
+		for (int32 i = 0; i < NumEntities; i++)
+		{
+			if (!ShouldStamp[i])
+			{
+				continue;
+			}
+			FIWMassBrushFragment& Brush = BrushFragments[i];
+			Brush.LastStampLocation = Transforms[i].GetTransform().GetLocation();
+			Brush.LastStampYaw = Yaw[i];
+			Brush.bHasStamped = true;
+
+			FIWStamp& Stamp = Stamps.AddDefaulted_GetRef();
+			Stamp.Location = FVector2D(LocationX[i], LocationY[i]);
+			Stamp.Size = Parameters.Size;
+			Stamp.Rotation = Yaw[i];
+			Stamp.Intensity = Parameters.Intensity;
+		}
+		InteractiveWorldSubsystem->SubmitStampBatch(Batch);
+	});
+}
@@ -0,0 +1,20 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractBrushMassTrait.h"
+
+#include "MassCommonFragments.h"
+#include "MassEntitySubsystem.h"
+#include "MassEntityTemplateRegistry.h"
+#include "StructUtilsTypes.h"
+
+void UInteractBrushMassTrait::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, UWorld& World) const
+{
+	BuildContext.AddFragment<FTransformFragment>();
+	BuildContext.AddFragment<FIWMassBrushFragment>();
+
+	UMassEntitySubsystem* EntitySubsystem = UWorld::GetSubsystem<UMassEntitySubsystem>(&World);
+	check(EntitySubsystem);
+	const uint32 ParametersHash = UE::StructUtils::GetStructCrc32(FConstStructView::Make(Parameters));
+	const FSharedStruct SharedParameters = EntitySubsystem->GetOrCreateSharedFragment<FIWMassBrushParameters>(ParametersHash, Parameters);
+	BuildContext.AddSharedFragment(SharedParameters);
+}
@@ -0,0 +1,17 @@
+// Copyright 2023 Sun BoHeng
+
+#include "InteractiveWorldMass.h"
+
+#define LOCTEXT_NAMESPACE "FInteractiveWorldMassModule"
+
+void FInteractiveWorldMassModule::StartupModule()
+{
+}
+
+void FInteractiveWorldMassModule::ShutdownModule()
+{
+}
+
+#undef LOCTEXT_NAMESPACE
+	
+IMPLEMENT_MODULE(FInteractiveWorldMassModule, InteractiveWorldMass)
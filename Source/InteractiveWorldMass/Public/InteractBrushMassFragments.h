@@ -0,0 +1,51 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "WorldDrawingBoard.h"
+#include "InteractBrushMassFragments.generated.h"
+
+//Per agent state,like InteractBrush's PreviousDrawnT
+USTRUCT()
+struct INTERACTIVEWORLDMASS_API FIWMassBrushFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	//Location when this agent stamped last time
+	FVector LastStampLocation = FVector::ZeroVector;
+
+	//Yaw when this agent stamped last time
+	float LastStampYaw = 0;
+
+	//Agent has not stamped yet,so it will stamp once whatever it moves
+	bool bHasStamped = false;
+};
+
+//Brush settings shared by agents of the same config,like properties of InteractBrush
+USTRUCT()
+struct INTERACTIVEWORLDMASS_API FIWMassBrushParameters : public FMassSharedFragment
+{
+	GENERATED_BODY()
+
+	//Material to draw stamps.Intensity will be written into vertex color
+	UPROPERTY(EditAnywhere, Category = "Interact Brush")
+	UMaterialInterface* Material = nullptr;
+
+	//Only draw on this class of DrawingBoards.None means all DrawingBoards
+	UPROPERTY(EditAnywhere, Category = "Interact Brush")
+	TSubclassOf<AWorldDrawingBoard> DrawingBoardClass;
+
+	//World size that agent will draw in
+	UPROPERTY(EditAnywhere, Category = "Interact Brush")
+	FVector2D Size = FVector2D(30, 30);
+
+	//Written into vertex color
+	UPROPERTY(EditAnywhere, Category = "Interact Brush")
+	float Intensity = 1;
+
+	//Tolerance of movement.X:Position tolerance,Y:Rotation tolerance.If greater than that will be considered as movement.
+	UPROPERTY(EditAnywhere, Category = "Interact Brush")
+	FVector2D MovementTolerance = FVector2D(0.1, 0.1);
+};
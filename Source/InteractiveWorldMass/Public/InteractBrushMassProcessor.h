@@ -0,0 +1,30 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "InteractBrushMassProcessor.generated.h"
+
+//Read agent transforms chunk by chunk,apply movement tolerance and culling like InteractBrush,
+//then submit stamps to InteractiveWorldSubsystem.One recycled batch for each chunk that has stamps.
+UCLASS()
+class INTERACTIVEWORLDMASS_API UInteractBrushMassProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UInteractBrushMassProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(UMassEntitySubsystem& EntitySubsystem, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+
+	//Viewer locations copied once per Execute,chunks test against this snapshot instead of
+	//the subsystem's ViewerSet which is rebuilt by its Tick.Kept between frames so steady state doesn't allocate
+	TArray<float> ViewerX;
+	TArray<float> ViewerY;
+};
@@ -0,0 +1,22 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTraitBase.h"
+#include "InteractBrushMassFragments.h"
+#include "InteractBrushMassTrait.generated.h"
+
+//Let Mass agents draw on DrawingBoards like an InteractBrush,without any actor or component
+UCLASS(meta = (DisplayName = "Interact Brush"))
+class INTERACTIVEWORLDMASS_API UInteractBrushMassTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+protected:
+	//Agents with the same parameters will share them
+	UPROPERTY(EditAnywhere, Category = "Interact Brush")
+	FIWMassBrushParameters Parameters;
+
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, UWorld& World) const override;
+};
@@ -0,0 +1,14 @@
+// Copyright 2023 Sun BoHeng
+
+#pragma once
+
+#include "Modules/ModuleManager.h"
+
+class FInteractiveWorldMassModule : public IModuleInterface
+{
+public:
+
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+};